@@ -7,7 +7,30 @@
 #define NES 1
 #include "6502.h"
 
-#include "6502_instr_timing.inl"
+#include "6502_profiler.inl"
+
+#if CPU_TRACE_RING
+cpu_trace_entry cpuTraceRing[CPU_TRACE_ENTRIES];
+unsigned int cpuTraceCount = 0;
+
+#define TRACE_RECORD(instr) \
+	{ \
+		cpu_trace_entry& entry = cpuTraceRing[cpuTraceCount++ & (CPU_TRACE_ENTRIES - 1)]; \
+		mainCPU.resolveToP(); \
+		entry.clocks = (uint32) (mainCPU.clocks - instr.clocks); \
+		entry.PC = mainCPU.PC; \
+		entry.opcode = instr.opcode; \
+		entry.data1 = instr.operand & 0xFF; \
+		entry.data2 = instr.operand >> 8; \
+		entry.A = mainCPU.A; \
+		entry.X = mainCPU.X; \
+		entry.Y = mainCPU.Y; \
+		entry.SP = mainCPU.SP; \
+		entry.P = mainCPU.P; \
+	}
+#else
+#define TRACE_RECORD(instr)
+#endif
 
 #if TRACE_DEBUG
 static unsigned int cpuBreakpoint = 0x10000;
@@ -68,6 +91,28 @@ const static int modeTableSmall[32] = {
 
 static int modeTable[256];
 
+// base clocks and byte size per opcode, used to decode instructions
+static unsigned char opClocks[256];
+static unsigned char opSize[256];
+
+// opcode stored in decoded ops for each opcode read from memory, so KIL opcodes in code remain illegal rather than
+// dispatching as fused sequences
+static unsigned char decodeOpcode[256];
+
+// counts fused sequence dispatches, off on device to keep the counter update out of the interpreter loop
+#if TARGET_PRIZM
+#define FUSED_OP_STATS 0
+#else
+#define FUSED_OP_STATS 1
+#endif
+
+#if FUSED_OP_STATS
+static unsigned int fusedCount[256] = { 0 };
+#define FUSED_COUNT(op) fusedCount[op]++;
+#else
+#define FUSED_COUNT(op)
+#endif
+
 void cpu6502_Init() {
 	for (int i = 0; i < 256; i++) {
 		modeTable[i] = modeTableSmall[i & 0x1F];
@@ -77,20 +122,36 @@ void cpu6502_Init() {
 	modeTable[0xB6] = AM_ZeroY;
 	modeTable[0xBE] = AM_AbsoluteY;
 
-	RegisterInstructionTimers();
+	// unsupported opcodes are treated as 2 byte 2 clock NOPs
+	memset(opClocks, 2, sizeof(opClocks));
+	memset(opSize, 2, sizeof(opSize));
+#define OPCODE_0W(op,str,clk,sz,page,name,spc) opClocks[op] = clk; opSize[op] = 1;
+#define OPCODE_1W(op,str,clk,sz,page,name,spc) opClocks[op] = clk; opSize[op] = 2;
+#define OPCODE_2W(op,str,clk,sz,page,name,spc) opClocks[op] = clk; opSize[op] = 3;
+#include "6502_opcodes.inl"
+
+	for (int op = 0; op < 256; op++) {
+		decodeOpcode[op] = op;
+	}
+#define OPCODE(mode,op,str,clk,sz,page,name,spc)
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) decodeOpcode[fused] = 0xFF;
+#include "6502_opcodes.inl"
+
 }
 
 void cpu_6502::resolveToP() {
-	mainCPU.P = (mainCPU.P & (~ST_ZRO & ~ST_NEG & ~ST_CRY)) |
+	mainCPU.P = (mainCPU.P & (~ST_ZRO & ~ST_NEG & ~ST_CRY & ~ST_OVR)) |
 		((mainCPU.zeroResult == 0) ? ST_ZRO : 0) |
 		(mainCPU.carryResult) |
-		(mainCPU.negativeResult & ST_NEG);
+		(mainCPU.negativeResult & ST_NEG) |
+		((mainCPU.overflowResult & 0x80) >> (7 - ST_OVR_BIT));
 }
 
 void cpu_6502::resolveFromP() {
 	mainCPU.zeroResult = (~mainCPU.P & ST_ZRO);
 	mainCPU.negativeResult = (mainCPU.P & ST_NEG);
 	mainCPU.carryResult = (mainCPU.P & ST_CRY);
+	mainCPU.overflowResult = (mainCPU.P & ST_OVR) << (7 - ST_OVR_BIT);
 }
 
 FORCE_INLINE void writeAddr(unsigned int addr, unsigned int result) {
@@ -246,11 +307,81 @@ FORCE_INLINE void PLP() {
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // BRANCH / JUMP
 
+// idle loop detection : a short backward branch whose loop body only loads and tests memory (LDA $2002 / BPL,
+// LDA flag / BEQ, BIT $2002 / BVC, etc) will spin identically until the next PPU/APU/IRQ event, so once a clean
+// pass of the loop has been seen whole iterations up to nextClocks are skipped
+#define IDLE_LOOP_MAX_BYTES 8
+
+// returns the clocks per iteration if the loop body from target up to the branch ending at branchEnd is side effect
+// free, 0 otherwise
+static unsigned int cpu6502_IdleLoopClocks(unsigned int target, unsigned int branchEnd) {
+	if (target >= 0x2000 && target < 0x5000)
+		return 0;
+
+	unsigned int loopClocks = 0;
+	const unsigned int branchAddr = (branchEnd - 2) & 0xFFFF;
+	while (target != branchAddr) {
+		const unsigned int op = mainCPU.readNonIO(target);
+		unsigned int address = 0;
+		switch (op) {
+			// LDA, LDX, LDY, BIT, CMP, CPX, CPY, AND, ORA zero page
+			case 0xA5: case 0xA6: case 0xA4: case 0x24: case 0xC5: case 0xE4: case 0xC4: case 0x25: case 0x05:
+				address = mainCPU.readNonIO(target + 1);
+				break;
+			// same for absolute, which may only read RAM or PPUSTATUS (reading it twice is the same as once)
+			case 0xAD: case 0xAE: case 0xAC: case 0x2C: case 0xCD: case 0xEC: case 0xCC: case 0x2D: case 0x0D:
+				address = mainCPU.readNonIO(target + 1) | (mainCPU.readNonIO(target + 2) << 8);
+				if (address >= 0x2000 && (address & 0xE007) != 0x2002)
+					return 0;
+				break;
+			// CMP, CPX, CPY, AND, ORA immediate
+			case 0xC9: case 0xE0: case 0xC0: case 0x29: case 0x09:
+				break;
+			default:
+				return 0;
+		}
+
+		loopClocks += opClocks[op];
+		target = (target + opSize[op]) & 0xFFFF;
+		if (loopClocks > IDLE_LOOP_MAX_BYTES * 4)
+			return 0;
+	}
+
+	// taken branch, with page cross
+	return loopClocks + 3 + (((branchEnd ^ target) & 0x100) ? 1 : 0);
+}
+
+static void cpu6502_IdleBranch(unsigned int branchEnd) {
+	if (branchEnd == mainCPU.idleBranchPC) {
+		// an exact iteration since the last time this branch was taken means no interrupt occurred during it
+		if (mainCPU.idleLoopClocks && mainCPU.clocks - mainCPU.idleBranchClocks == mainCPU.idleLoopClocks && CLOCKS_BEFORE(mainCPU.clocks, mainCPU.nextClocks)) {
+			// verify the loop code again in case it was banked or rewritten, then skip whole iterations (the remaining
+			// partial iteration runs normally to keep exact timing)
+			if (cpu6502_IdleLoopClocks(mainCPU.PC, branchEnd) == mainCPU.idleLoopClocks) {
+				const unsigned int skip = (unsigned int) (mainCPU.nextClocks - mainCPU.clocks - 1) / mainCPU.idleLoopClocks * mainCPU.idleLoopClocks;
+				mainCPU.clocks += skip;
+				mainCPU.idleClocksSkipped += skip;
+				PROFILE_IDLE(branchEnd, skip);
+			}
+		}
+	} else {
+		mainCPU.idleBranchPC = branchEnd;
+		mainCPU.idleLoopClocks = cpu6502_IdleLoopClocks(mainCPU.PC, branchEnd);
+	}
+
+	mainCPU.idleBranchClocks = mainCPU.clocks;
+}
+
 FORCE_INLINE void takeBranch(unsigned int data) {
 	unsigned int oldPC = mainCPU.PC;
 	mainCPU.PC += (char) (data);
 	mainCPU.clocks++;
 	if ((oldPC ^ mainCPU.PC) & 0x100) mainCPU.clocks++;
+
+	// short backward branches may be idle loops (not skipped when tracing so every instruction is traced)
+	if (!CPU_TRACE_RING && (char) data < 0 && (char) data >= -(IDLE_LOOP_MAX_BYTES + 2)) {
+		cpu6502_IdleBranch(oldPC);
+	}
 }
 
 FORCE_INLINE void BPL(unsigned int data) {
@@ -266,13 +397,13 @@ FORCE_INLINE void BMI(unsigned int data) {
 }
 
 FORCE_INLINE void BVC(unsigned int data) {
-	if (!(mainCPU.P & ST_OVR)) {
+	if (!(mainCPU.overflowResult & 0x80)) {
 		takeBranch(data);
 	}
 }
 
 FORCE_INLINE void BVS(unsigned int data) {
-	if (mainCPU.P & ST_OVR) {
+	if (mainCPU.overflowResult & 0x80) {
 		takeBranch(data);
 	}
 }
@@ -303,11 +434,16 @@ FORCE_INLINE void BEQ(unsigned int data) {
 
 FORCE_INLINE void JMP_MEM(unsigned int addr) {
 	// common infinite loop
-	if (mainCPU.PC == addr + 3) {
+	if (!CPU_TRACE_RING && mainCPU.PC == addr + 3) {
 		// skip ahead until next interrupt
-		for (; mainCPU.clocks < mainCPU.nextClocks;) {
+#if CPU_PROFILER
+		const cpu_clock startClocks = mainCPU.clocks;
+#endif
+		for (; CLOCKS_BEFORE(mainCPU.clocks, mainCPU.nextClocks);) {
 			mainCPU.clocks += 3;
+			mainCPU.idleClocksSkipped += 3;
 		}
+		PROFILE_IDLE(addr, (unsigned int) (mainCPU.clocks - startClocks));
 	}
 
 	mainCPU.PC = addr;
@@ -341,9 +477,7 @@ FORCE_INLINE void RTS() {
 
 FORCE_INLINE void ADC(unsigned int data) {
 	unsigned int result = mainCPU.A + data + mainCPU.carryResult;
-	mainCPU.P =
-		(mainCPU.P & (ST_INT | ST_BRK | ST_BCD | ST_UNUSED)) |					// keep flags
-		(((mainCPU.A^result)&(data^result) & 0x80) >> (7 - ST_OVR_BIT));		// overflow (http://www.righto.com/2012/12/the-6502-overflow-flag-explained.html)
+	mainCPU.overflowResult = (mainCPU.A^result)&(data^result);				// overflow (http://www.righto.com/2012/12/the-6502-overflow-flag-explained.html)
 	mainCPU.A = result & 0xFF;
 	mainCPU.carryResult = result >> 8;
 	mainCPU.zeroResult = mainCPU.A;
@@ -359,11 +493,8 @@ FORCE_INLINE void ADC_ZERO(unsigned int address) {
 }
 
 FORCE_INLINE void SBC(unsigned int data) {
-	// TODO : possibly move overflow calculation to flag resolve?
 	unsigned int result = mainCPU.A - data - 1 + mainCPU.carryResult;
-	mainCPU.P =
-		(mainCPU.P & (ST_INT | ST_BRK | ST_BCD | ST_UNUSED)) |					// keep flags
-		(((mainCPU.A^result)&((~(data)) ^ result) & 0x80) >> (7 - ST_OVR_BIT));	// overflow (http://www.righto.com/2012/12/the-6502-overflow-flag-explained.html)
+	mainCPU.overflowResult = (mainCPU.A^result)&((~(data)) ^ result);		// overflow (http://www.righto.com/2012/12/the-6502-overflow-flag-explained.html)
 	mainCPU.A = result & 0xFF;
 	mainCPU.carryResult = (~result & 0x100) >> 8;
 	mainCPU.zeroResult = mainCPU.A;
@@ -657,9 +788,7 @@ FORCE_INLINE void ROR_ZERO(unsigned int address) {
 }
 
 FORCE_INLINE void BIT(unsigned int data) {
-	mainCPU.P =
-		(mainCPU.P & (ST_INT | ST_BCD | ST_BRK | ST_CRY | ST_UNUSED)) |		// keep flags
-		(data & (ST_OVR | ST_NEG));											// these are copied in (bits 6-7)
+	mainCPU.overflowResult = data << (7 - ST_OVR_BIT);						// bit 6 copied in as V
 	mainCPU.zeroResult = (data & mainCPU.A);
 	mainCPU.negativeResult = data;
 }
@@ -698,7 +827,7 @@ FORCE_INLINE void SEI() {
 
 FORCE_INLINE void CLV() {
 	// (clear overflow)
-	mainCPU.P &= ~ST_OVR;
+	mainCPU.overflowResult = 0;
 }
 
 FORCE_INLINE void CLD() {
@@ -719,6 +848,162 @@ unsigned int eff_address(unsigned int addr) { effAddr = addr; if (effAddr < 0x20
 #define eff_address(X) (X)
 #endif
 
+// decodes the instruction at the given address directly from memory
+FORCE_INLINE void cpu6502_DecodeOp(nes_decoded_op& op, unsigned int address) {
+	op.opcode = decodeOpcode[mainCPU.readNonIO(address)];
+	op.clocks = opClocks[op.opcode];
+	op.operand = mainCPU.readNonIO(address + 1);
+	if (opSize[op.opcode] == 3) {
+		op.operand |= mainCPU.readNonIO(address + 2) << 8;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FUSED SEQUENCES
+
+// each runs its first instruction(s) and stops at the next if the cpu is due to stop for an event before it (the base
+// clocks of the whole sequence were already added), so events and interrupts land between instructions as before
+#define FUSED_STOP(offset, remainingClocks) \
+	if (!CLOCKS_BEFORE(mainCPU.clocks - (remainingClocks), mainCPU.nextClocks)) { \
+		mainCPU.clocks -= (remainingClocks); \
+		mainCPU.PC += (offset); \
+		return; \
+	}
+
+FORCE_INLINE void FUSED_DEX_BNE(unsigned int operand) {
+	DEX();
+	FUSED_STOP(1, 2);
+	mainCPU.PC += 3;
+	BNE(operand & 0xFF);
+}
+
+FORCE_INLINE void FUSED_DEY_BNE(unsigned int operand) {
+	DEY();
+	FUSED_STOP(1, 2);
+	mainCPU.PC += 3;
+	BNE(operand & 0xFF);
+}
+
+FORCE_INLINE void FUSED_INX_CPX_BNE(unsigned int operand) {
+	INX();
+	FUSED_STOP(1, 4);
+	CPX(operand & 0xFF);
+	FUSED_STOP(3, 2);
+	mainCPU.PC += 5;
+	BNE(operand >> 8);
+}
+
+FORCE_INLINE void FUSED_INY_CPY_BNE(unsigned int operand) {
+	INY();
+	FUSED_STOP(1, 4);
+	CPY(operand & 0xFF);
+	FUSED_STOP(3, 2);
+	mainCPU.PC += 5;
+	BNE(operand >> 8);
+}
+
+FORCE_INLINE void FUSED_LDA_BEQ(unsigned int operand) {
+	LDA_ZERO(operand & 0xFF);
+	FUSED_STOP(2, 2);
+	mainCPU.PC += 4;
+	BEQ(operand >> 8);
+}
+
+FORCE_INLINE void FUSED_LDA_BNE(unsigned int operand) {
+	LDA_ZERO(operand & 0xFF);
+	FUSED_STOP(2, 2);
+	mainCPU.PC += 4;
+	BNE(operand >> 8);
+}
+
+FORCE_INLINE void FUSED_LDA_STA_ZERO(unsigned int operand) {
+	LDA(operand & 0xFF);
+	FUSED_STOP(2, 3);
+	mainCPU.PC += 4;
+	STA_ZERO(operand >> 8);
+}
+
+FORCE_INLINE void FUSED_LDA_STA_MEM(unsigned int operand) {
+	LDA(operand & 0xFF);
+	FUSED_STOP(2, 4);
+	// the address doesn't fit the packed operand, it is taken from the STA's own decoded op
+	const unsigned int address = mainCPU.decodedMap[(mainCPU.PC >> 13) & 7][(mainCPU.PC + 2) & 0x1FFF].operand;
+	mainCPU.PC += 5;
+	STA_MEM(address);
+}
+
+// replaces a decoded op with a fused sequence if it begins one that is contained in the same 8 KB bank
+static void cpu6502_FuseOp(nes_decoded_op& op, unsigned int address, nes_decoded_op* decoded) {
+	const unsigned int op2Addr = address + opSize[op.opcode];
+	const unsigned int nextOpcode = mainCPU.readNonIO(op2Addr);
+
+	// when the operands don't fit in 16 bits, the second instruction is decoded into its own slot for the sequence to
+	// read (any change to its bytes also invalidates the sequence, which is within MAX_DECODED_OP_SIZE of them)
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) \
+	if (op.opcode == op1 && nextOpcode == op2 && (address & 0x1FFF) + size <= 0x2000 && (op3 == 0 || mainCPU.readNonIO(op2Addr + opSize[op2]) == op3)) { \
+		op.opcode = fused; \
+		op.clocks = opClocks[op1] + opClocks[op2] + (op3 ? opClocks[op3] : 0); \
+		if (opSize[op1] == 1) { \
+			op.operand = mainCPU.readNonIO(op2Addr + 1) | (op3 ? mainCPU.readNonIO(op2Addr + opSize[op2] + 1) << 8 : 0); \
+		} else { \
+			op.operand = (op.operand & 0xFF) | (mainCPU.readNonIO(op2Addr + 1) << 8); \
+		} \
+		if (opSize[op1] + opSize[op2] > 4) { \
+			cpu6502_DecodeOp(decoded[op2Addr & 0x1FFF], op2Addr); \
+		} \
+		return; \
+	}
+#define OPCODE(mode,op,str,clk,sz,page,name,spc)
+#include "6502_opcodes.inl"
+}
+
+void cpu6502_FusedReport() {
+#if FUSED_OP_STATS
+	printf("%-24s %12s\n", "fused sequence", "count");
+#define OPCODE(mode,op,str,clk,sz,page,name,spc)
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) printf("%-24s %12u\n", str, fusedCount[fused]);
+#include "6502_opcodes.inl"
+#endif
+}
+
+// decodes the op at PC when it isn't in the decoded op table, storing it there if PC is in a decoded bank
+static void cpu6502_DecodeAtPC(nes_decoded_op& op, nes_decoded_op* decoded) {
+	cpu6502_DecodeOp(op, mainCPU.PC);
+	if (decoded && (mainCPU.PC & 0x1FFF) + opSize[op.opcode] <= 0x2000) {
+#if !TRACE_DEBUG
+		// traces are per instruction, so sequences are only fused when not tracing
+		if (!CPU_TRACE_RING) cpu6502_FuseOp(op, mainCPU.PC, decoded);
+#endif
+		decoded[mainCPU.PC & 0x1FFF] = op;
+	}
+}
+
+// fetches the op at PC and adds its base clocks. Ops are dispatched from the decoded op table for mapped PRG ROM,
+// decoding on first execution. Code elsewhere (RAM, WRAM) is decoded every time since it may be modified, as are
+// instructions that straddle an 8 KB bank boundary
+#define FETCH_OP(instr) \
+	{ \
+		nes_decoded_op* decoded = mainCPU.decodedMap[(mainCPU.PC >> 13) & 7]; \
+		if (decoded && decoded[mainCPU.PC & 0x1FFF].clocks != DECODED_OP_EMPTY) { \
+			/* single word copy of the record */ \
+			memcpy(&instr, &decoded[mainCPU.PC & 0x1FFF], sizeof(instr)); \
+		} else { \
+			cpu6502_DecodeAtPC(instr, decoded); \
+		} \
+		mainCPU.clocks += instr.clocks; \
+		TRACE_RECORD(instr); \
+	}
+
+// resolves a PPU or special register access latched by the last instruction
+#define LATCH_ACCESSES() \
+	if (mainCPU.accessTable[0x2000 >> 13]) { \
+		nesPPU.latchedReg(mainCPU.accessTable[0x2000 >> 13]); \
+		mainCPU.accessTable[0x2000 >> 13] = 0; \
+	} else if (mainCPU.accessTable[0x4000 >> 13]) { \
+		mainCPU.latchedSpecial(mainCPU.accessTable[0x4000 >> 13]); \
+		mainCPU.accessTable[0x4000 >> 13] = 0; \
+	}
+
 FORCE_INLINE void cpu6502_PerformInstruction() {
 #if TRACE_DEBUG
 	cpu_instr_history hist;
@@ -732,96 +1017,20 @@ FORCE_INLINE void cpu6502_PerformInstruction() {
 #endif
 
 
-	unsigned char instr = mainCPU.readNonIO(mainCPU.PC++);
-	unsigned char data1 = mainCPU.readNonIO(mainCPU.PC++);
-
-	// all instructions at least 2 clks
-	mainCPU.clocks += 2;
+	nes_decoded_op instr;
+	FETCH_OP(instr);
+	const unsigned int data1 = instr.operand & 0xFF;
 
+#define OPCODE_CASE(op) case op:
+#define OPCODE_BREAK break
 #define SKIP_LATCHING() goto SkipLatching;
-#define OPCODE_START(op,clk,sz) case op: { INSTR_TIMING(op); mainCPU.clocks += (clk-2);
-#define OPCODE_END(spc) spc break; }
-
-#define OPCODE_NON(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		mainCPU.PC--; \
-		name(); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc) 
-
-#define OPCODE_IMM(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		name(data1); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc) 
-
-#define OPCODE_REL(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		name(data1); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc) 
-
-#define OPCODE_ABS(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		unsigned int data2 = mainCPU.readNonIO(mainCPU.PC++); \
-		name##_MEM(eff_address(data1 + (data2 << 8))); \
-	OPCODE_END(spc) 
-
-#define OPCODE_ABX(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		unsigned int data2 = mainCPU.readNonIO(mainCPU.PC++); \
-		if (page && ((data1 + mainCPU.X) & 0x100)) mainCPU.clocks++; \
-		name##_MEM(eff_address(data1 + (data2 << 8) + (mainCPU.X))); \
-	OPCODE_END(spc) 
-
-#define OPCODE_ABY(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		unsigned int data2 = mainCPU.readNonIO(mainCPU.PC++); \
-		if (page && ((data1 + mainCPU.Y) & 0x100)) mainCPU.clocks++;	\
-		name##_MEM(eff_address(data1 + (data2 << 8) + (mainCPU.Y))); \
-	OPCODE_END(spc) 
-
-#define OPCODE_IND(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		unsigned int data2 = mainCPU.readNonIO(mainCPU.PC++); \
-		unsigned int target = (data2 << 8); \
-		name##_MEM(eff_address(mainCPU.readNonIO(data1 + target) + (mainCPU.readNonIO(((data1 + 1) & 0xFF) + target) << 8))); \
-	OPCODE_END(spc)
-
-#define OPCODE_INX(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		int target = (data1 + mainCPU.X) & 0xFF; \
-		name##_MEM(eff_address(CPU_RAM(target) + (CPU_RAM((target + 1) & 0xFF) << 8))); \
-	OPCODE_END(spc)
-
-#define OPCODE_INY(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		if (page && ((CPU_RAM(data1) + mainCPU.Y) & 0x100)) mainCPU.clocks++; \
-		name##_MEM(eff_address(CPU_RAM(data1) + (CPU_RAM((data1 + 1) & 0xFF) << 8) + mainCPU.Y)); \
-	OPCODE_END(spc) 
-
-#define OPCODE_ZRO(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		name##_ZERO(eff_address(data1)); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc)
-
-#define OPCODE_ZRX(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		name##_ZERO(eff_address((data1 + mainCPU.X) & 0xFF)); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc) 
-
-#define OPCODE_ZRY(op,str,clk,sz,page,name,spc) \
-	OPCODE_START(op,clk,sz) \
-		name##_ZERO(eff_address((data1 + mainCPU.Y) & 0xFF)); \
-		SKIP_LATCHING(); \
-	OPCODE_END(spc)
-
-	switch (instr) {
+#include "6502_dispatch.inl"
+
+	switch (instr.opcode) {
 		#include "6502_opcodes.inl"
 		default:
 		{
+			mainCPU.PC += 2;
 #if TRACE_DEBUG
 			IllegalInstruction();
 #else
@@ -830,20 +1039,14 @@ FORCE_INLINE void cpu6502_PerformInstruction() {
 		}
 	};
 
-	if (mainCPU.accessTable[0x2000 >> 13]) {
-		nesPPU.latchedReg(mainCPU.accessTable[0x2000 >> 13]);
-		mainCPU.accessTable[0x2000 >> 13] = 0;
-	} else if (mainCPU.accessTable[0x4000 >> 13]) {
-		mainCPU.latchedSpecial(mainCPU.accessTable[0x4000 >> 13]);
-		mainCPU.accessTable[0x4000 >> 13] = 0;
-	}
+	LATCH_ACCESSES();
 
 SkipLatching:
 
 	// sanity checks
 	DebugAssert(mainCPU.carryResult == 0 || mainCPU.carryResult == 1);
 #if TRACE_DEBUG
-	if (instr == 0x60 && mainCPU.PC > 1) {
+	if (instr.opcode == 0x60 && mainCPU.PC > 1) {
 		// RTS special case:
 		effAddr = (mainCPU.readNonIO(mainCPU.PC - 1) << 8) + mainCPU.readNonIO(mainCPU.PC - 2);
 	}
@@ -880,35 +1083,79 @@ SkipLatching:
 		HitBreakpoint();
 	}
 #endif
+
+#undef OPCODE_CASE
+#undef OPCODE_BREAK
+#undef SKIP_LATCHING
 }
 
+#if CPU_THREADED_DISPATCH
+// runs instructions until nextClocks. Each handler ends with its own fetch and jump to the next handler, so the
+// indirect branch at the end of each handler is predicted on its own rather than all sharing one switch branch
+static void cpu6502_Run() {
+	static const void* dispatchTable[256];
+	static bool bDispatchTableSet = false;
+	if (!bDispatchTableSet) {
+		for (int op = 0; op < 256; op++) {
+			dispatchTable[op] = &&IllegalOp;
+		}
+#define OPCODE(mode,op,str,clk,sz,page,name,spc) dispatchTable[op] = &&Op_##op;
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) dispatchTable[fused] = &&Op_##fused;
+#include "6502_opcodes.inl"
+		bDispatchTableSet = true;
+	}
+
+	nes_decoded_op instr;
+	unsigned int data1;
+
+#define NEXT_OP() \
+	if (!CLOCKS_BEFORE(mainCPU.clocks, mainCPU.nextClocks)) return; \
+	FETCH_OP(instr); \
+	data1 = instr.operand & 0xFF; \
+	goto *dispatchTable[instr.opcode];
+
+	NEXT_OP();
+
+#define OPCODE_CASE(op) Op_##op:
+#define OPCODE_BREAK goto Latching
+#define SKIP_LATCHING() NEXT_OP()
+#include "6502_dispatch.inl"
+#include "6502_opcodes.inl"
+
+IllegalOp:
+	mainCPU.PC += 2;
+	DebugAssert(false);
+	NEXT_OP();
+
+Latching:
+	LATCH_ACCESSES();
+	NEXT_OP();
+
+#undef OPCODE_CASE
+#undef OPCODE_BREAK
+#undef SKIP_LATCHING
+#undef NEXT_OP
+}
+#endif
+
 void cpu6502_Step() {
 	TIME_SCOPE();
 
-	// stop at next PPU or IRQ
-	mainCPU.nextClocks = mainCPU.ppuClocks;
+	// stop at the next event in the queue
+	mainCPU.nextClocks = mainCPU.firstEventClocks();
 
-	// only consider IRQ if the cpu is enabling interrupts
-	if (mainCPU.irqMask && (mainCPU.P & ST_INT) == 0) {
-		if ((mainCPU.irqMask & 0x01) && mainCPU.irqClock[0] < mainCPU.nextClocks) mainCPU.nextClocks = mainCPU.irqClock[0];
-		if ((mainCPU.irqMask & 0x02) && mainCPU.irqClock[1] < mainCPU.nextClocks) mainCPU.nextClocks = mainCPU.irqClock[1];
-		if ((mainCPU.irqMask & 0x04) && mainCPU.irqClock[2] < mainCPU.nextClocks) mainCPU.nextClocks = mainCPU.irqClock[2];
-		if ((mainCPU.irqMask & 0x08) && mainCPU.irqClock[3] < mainCPU.nextClocks) mainCPU.nextClocks = mainCPU.irqClock[3];
-	}
-	if (mainCPU.apuClocks < mainCPU.nextClocks) {
-		mainCPU.nextClocks = mainCPU.apuClocks;
-	}
-	if (mainCPU.ppuNMI && mainCPU.nextClocks > mainCPU.clocks + 7) {
-		mainCPU.nextClocks = mainCPU.clocks + 7;
-	}
-
-	for (; mainCPU.clocks < mainCPU.nextClocks;) {
+#if CPU_THREADED_DISPATCH
+	cpu6502_Run();
+#else
+	for (; CLOCKS_BEFORE(mainCPU.clocks, mainCPU.nextClocks);) {
 		cpu6502_PerformInstruction();
 	}
+#endif
 
-	if (mainCPU.ppuNMI) {
+	// a pending NMI occurs on completion of the instruction, whichever event stopped the cpu
+	if (mainCPU.isScheduled(EVENT_NMI)) {
+		mainCPU.cancel(EVENT_NMI);
 		mainCPU.NMI();
-		mainCPU.ppuNMI = false;
 	}
 }
 
@@ -956,7 +1203,7 @@ void cpu_instr_history::output() {
 
 	static bool showClocks = false;
 	if (showClocks) {
-		ADD_LOG("c%-11d ", regs.clocks);
+		ADD_LOG("c%-11d ", (int) regs.clocks);
 	}
 	static bool showRegs = true;
 	if (showRegs) {
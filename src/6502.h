@@ -27,35 +27,17 @@ struct cpu_6502 {
 	unsigned int Y;
 	unsigned int P;		// processor status flags, 8-bit
 
-	// Zero and negative flags are stored as their results only until they need to be resolved
+	// Zero, negative, carry and overflow flags are stored as their results only until they need to be resolved
 	unsigned int carryResult;			// C if 1 or 0 (same as ST_CRY)
 	unsigned int zeroResult;			// Z if 0
 	unsigned int negativeResult;		// N if ST_NEG is set
+	unsigned int overflowResult;		// V if bit 7 is set (ADC/SBC operand and result sign product)
 
 	// clock cycle counter
-	unsigned int clocks;
+	cpu_clock clocks;
 
 	// next time instructions check for interrupts, PPU step, etc
-	unsigned int nextClocks;
-
-	// represents a low IRQ latch if any are non 0 and our CPU clocks are past a given counter (for speed), up to 4 supported
-	unsigned int irqMask;
-	unsigned int irqClock[4];
-
-	// set the irq for the given irq number (clocks = 0 to immediately trigger)
-	void setIRQ(int irqNum, unsigned int clocks) {
-		// don't set clocks forward if already acknowledged
-		if ((irqMask & (1 << irqNum)) && clocks > irqClock[irqNum])
-			clocks = irqClock[irqNum];
-
-		irqMask |= (1 << irqNum);
-		irqClock[irqNum] = clocks;
-	}
-
-	// acknowledge the given irq number
-	void ackIRQ(int irqNum) {
-		irqMask &= ~(1 << irqNum);
-	}
+	cpu_clock nextClocks;
 
 	// resolve the cached results to P
 	void resolveToP();
@@ -101,6 +83,14 @@ void cpu6502_Init();
 // this is done statically to obtain static addressing optimizations
 void cpu6502_Step();
 
+// outputs how often each fused instruction sequence was executed (when FUSED_OP_STATS is enabled)
+void cpu6502_FusedReport();
+
+// sampling profiler (6502_profiler.inl, does nothing unless CPU_PROFILER is enabled). Reset clears the counts, and the
+// report is written to a file when leaving the game loop
+void cpu6502_ProfileReset();
+void cpu6502_ProfileReport();
+
 // performs IRQ interrupt
 void cpu6502_IRQ(int irqBit);
 
@@ -122,4 +112,53 @@ extern nes_cpu mainCPU ALIGN(256);
 #define TRACE_DEBUG 1
 #else
 #define TRACE_DEBUG 0
-#endif
\ No newline at end of file
+#endif
+
+// instruction dispatch through a table of handler labels (GCC computed goto) with each handler fetching and jumping
+// to the next, rather than a single switch. Measures within a few percent of the switch either way on host, so it is
+// opt in (HOST_FLAGS=-DCPU_THREADED_DISPATCH=1). Not available while tracing, which expects one instruction per call
+#ifndef CPU_THREADED_DISPATCH
+#define CPU_THREADED_DISPATCH 0
+#endif
+
+#if CPU_THREADED_DISPATCH && (!defined(__GNUC__) || TRACE_DEBUG)
+#undef CPU_THREADED_DISPATCH
+#define CPU_THREADED_DISPATCH 0
+#endif
+
+// opcode and PC sampling profiler, replaces per instruction scope timers (HOST_FLAGS=-DCPU_PROFILER=1 on host)
+#ifndef CPU_PROFILER
+#define CPU_PROFILER 0
+#endif
+
+// binary instruction trace ring (host only, HOST_FLAGS=-DCPU_TRACE_RING=1). Each instruction executed records one
+// entry, which host_trace.cpp dumps to a file and converts to FCEUX trace text. Sequence fusion and idle loop skipping
+// are disabled while enabled so every instruction is traced
+#ifndef CPU_TRACE_RING
+#define CPU_TRACE_RING 0
+#endif
+
+#if CPU_TRACE_RING
+// number of entries kept, must be a power of 2
+#define CPU_TRACE_ENTRIES (1 << 20)
+
+// registers before the instruction
+struct cpu_trace_entry {
+	uint32 clocks;			// low 32 bits of the clock at the start of the instruction
+	uint16 PC;
+	uint8 opcode;
+	uint8 data1;
+	uint8 data2;
+	uint8 A;
+	uint8 X;
+	uint8 Y;
+	uint8 SP;
+	uint8 P;
+	uint8 pad[2];
+};
+
+extern cpu_trace_entry cpuTraceRing[CPU_TRACE_ENTRIES];
+
+// total number of instructions recorded, the newest is at (cpuTraceCount - 1) & (CPU_TRACE_ENTRIES - 1)
+extern unsigned int cpuTraceCount;
+#endif
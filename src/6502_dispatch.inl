@@ -0,0 +1,91 @@
+// Handler bodies for each addressing mode of the opcode table (6502_opcodes.inl), included by each dispatch mode
+// in 6502.cpp. The including code defines how handlers are entered and left:
+//  OPCODE_CASE(op)			entry label for an opcode
+//  OPCODE_BREAK			leave a handler through the latched access check
+//  SKIP_LATCHING()			leave a handler that can't have latched an access
+// and has instr (the decoded op) and data1 (its first operand byte) in scope
+
+#define OPCODE_START(op,clk,sz,width) OPCODE_CASE(op) { PROFILE_OP(op); mainCPU.PC += width;
+#define OPCODE_END(spc) spc OPCODE_BREAK; }
+
+#define OPCODE_NON(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,1) \
+		name(); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc) 
+
+#define OPCODE_IMM(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		name(data1); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc) 
+
+#define OPCODE_REL(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		name(data1); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc) 
+
+#define OPCODE_ABS(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,3) \
+		name##_MEM(eff_address(instr.operand)); \
+	OPCODE_END(spc) 
+
+#define OPCODE_ABX(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,3) \
+		if (page && ((data1 + mainCPU.X) & 0x100)) mainCPU.clocks++; \
+		name##_MEM(eff_address(instr.operand + (mainCPU.X))); \
+	OPCODE_END(spc) 
+
+#define OPCODE_ABY(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,3) \
+		if (page && ((data1 + mainCPU.Y) & 0x100)) mainCPU.clocks++;	\
+		name##_MEM(eff_address(instr.operand + (mainCPU.Y))); \
+	OPCODE_END(spc) 
+
+#define OPCODE_IND(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,3) \
+		unsigned int target = (instr.operand & 0xFF00); \
+		name##_MEM(eff_address(mainCPU.readNonIO(data1 + target) + (mainCPU.readNonIO(((data1 + 1) & 0xFF) + target) << 8))); \
+	OPCODE_END(spc)
+
+#define OPCODE_INX(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		int target = (data1 + mainCPU.X) & 0xFF; \
+		name##_MEM(eff_address(CPU_RAM(target) + (CPU_RAM((target + 1) & 0xFF) << 8))); \
+	OPCODE_END(spc)
+
+#define OPCODE_INY(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		if (page && ((CPU_RAM(data1) + mainCPU.Y) & 0x100)) mainCPU.clocks++; \
+		name##_MEM(eff_address(CPU_RAM(data1) + (CPU_RAM((data1 + 1) & 0xFF) << 8) + mainCPU.Y)); \
+	OPCODE_END(spc) 
+
+#define OPCODE_ZRO(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		name##_ZERO(eff_address(data1)); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc)
+
+#define OPCODE_ZRX(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		name##_ZERO(eff_address((data1 + mainCPU.X) & 0xFF)); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc) 
+
+#define OPCODE_ZRY(op,str,clk,sz,page,name,spc) \
+	OPCODE_START(op,clk,sz,2) \
+		name##_ZERO(eff_address((data1 + mainCPU.Y) & 0xFF)); \
+		SKIP_LATCHING(); \
+	OPCODE_END(spc)
+
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) \
+	OPCODE_CASE(fused) { \
+		FUSED_COUNT(fused); \
+		PROFILE_OP(fused); \
+		FUSED_##name(instr.operand); \
+		if (!latch) { \
+			SKIP_LATCHING(); \
+		} \
+		OPCODE_BREAK; \
+	}
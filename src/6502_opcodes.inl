@@ -236,4 +236,19 @@ OPCODE_ABX( 0xfe,		"INC $%04X,Y",		7,	3,	0, INC, {}		)
 #undef OPCODE_INY
 #undef OPCODE_ZRO
 #undef OPCODE_ZRX
-#undef OPCODE_ZRY
\ No newline at end of file
+#undef OPCODE_ZRY
+
+// fused instruction sequences, executed in a single dispatch from decoded ops (see cpu6502_FuseOp). The fused opcodes
+// are KIL opcodes, which halt a real 6502, and the decoded operand holds the first two operand bytes of the sequence
+// FUSED_OP(FusedOpcode, Opcode1, Opcode2, Opcode3 (0 if none), SequenceString, Size, Latch, Name)
+#ifdef FUSED_OP
+FUSED_OP( 0x02,		0xca, 0xd0, 0x00,	"DEX / BNE",				3,	0, DEX_BNE		)
+FUSED_OP( 0x12,		0x88, 0xd0, 0x00,	"DEY / BNE",				3,	0, DEY_BNE		)
+FUSED_OP( 0x22,		0xe8, 0xe0, 0xd0,	"INX / CPX # / BNE",		5,	0, INX_CPX_BNE	)
+FUSED_OP( 0x32,		0xc8, 0xc0, 0xd0,	"INY / CPY # / BNE",		5,	0, INY_CPY_BNE	)
+FUSED_OP( 0x42,		0xa5, 0xf0, 0x00,	"LDA zp / BEQ",				4,	0, LDA_BEQ		)
+FUSED_OP( 0x52,		0xa5, 0xd0, 0x00,	"LDA zp / BNE",				4,	0, LDA_BNE		)
+FUSED_OP( 0x62,		0xa9, 0x85, 0x00,	"LDA # / STA zp",			4,	0, LDA_STA_ZERO	)
+FUSED_OP( 0x72,		0xa9, 0x8d, 0x00,	"LDA # / STA abs",			5,	1, LDA_STA_MEM	)
+#undef FUSED_OP
+#endif
\ No newline at end of file
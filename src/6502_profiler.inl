@@ -0,0 +1,225 @@
+// sampling cpu profiler (enabled with CPU_PROFILER, see 6502.h). Counts every dispatched opcode, and the first op
+// dispatched each PROFILE_SAMPLE_CLOCKS charges the clocks since the last sample to its PC (by PRG bank), with clocks
+// skipped by idle loop detection also tracked per loop. Sampling is done at dispatch rather than as a cpu event so the
+// profiler never changes where the cpu stops. cpu6502_ProfileReport() writes the sorted results to PROFILE_REPORT_FILE
+
+#if CPU_PROFILER
+// sample period, chosen not to divide evenly into a scanline so samples don't alias to the frame
+#define PROFILE_SAMPLE_CLOCKS 97
+
+// must be a power of 2, PCs past the table capacity are only counted in profileDroppedClocks
+#define PROFILE_PC_ENTRIES 8192
+
+#define PROFILE_TOP_OPCODES 40
+#define PROFILE_TOP_PER_BANK 16
+#define PROFILE_TOP_IDLE 16
+
+#define PROFILE_REPORT_FILE "\\\\fls0\\nesizm_profile.txt"
+
+struct cpu_profile_pc {
+	uint32 key;				// PROFILE_KEY of the PC, 0 if unused
+	uint32 clocks;			// sampled clocks at this PC
+	uint32 idleClocks;		// clocks skipped in an idle loop ending at this PC
+};
+
+#define PROFILE_KEY(bank, pc) (0x80000000 | (((bank) & 0x7FFF) << 16) | (pc))
+#define PROFILE_KEY_BANK(key) ((int) (((key) >> 16) & 0x7FFF) == 0x7FFF ? -1 : (int) (((key) >> 16) & 0x7FFF))
+#define PROFILE_KEY_PC(key) ((key) & 0xFFFF)
+
+static unsigned int profileOpCount[256];
+static cpu_profile_pc profilePCs[PROFILE_PC_ENTRIES];
+static unsigned long long profileSampledClocks;
+static unsigned long long profileDroppedClocks;
+static unsigned long long profileIdleClocks;
+static cpu_clock profileLastSample;
+static cpu_clock profileNextSample;
+
+// PRG bank mapped at the given PC, or -1 for RAM / WRAM
+static int cpu6502_ProfileBank(unsigned int pc) {
+	if (pc >= 0x8000) {
+		return nesCart.programBanks[(pc >> 13) & 3];
+	}
+	if (pc >= 0x6000 && nesCart.isLowPRGROM) {
+		return nesCart.programBanks[4];
+	}
+	return -1;
+}
+
+static cpu_profile_pc* cpu6502_ProfileEntry(unsigned int pc) {
+	const uint32 key = PROFILE_KEY(cpu6502_ProfileBank(pc), pc);
+	unsigned int index = (key ^ (key >> 13)) & (PROFILE_PC_ENTRIES - 1);
+	for (int probe = 0; probe < 32; probe++) {
+		cpu_profile_pc& entry = profilePCs[index];
+		if (entry.key == key) {
+			return &entry;
+		}
+		if (entry.key == 0) {
+			entry.key = key;
+			return &entry;
+		}
+		index = (index + 1) & (PROFILE_PC_ENTRIES - 1);
+	}
+	return nullptr;
+}
+
+void cpu6502_ProfileReset() {
+	memset(profileOpCount, 0, sizeof(profileOpCount));
+	memset(profilePCs, 0, sizeof(profilePCs));
+	profileSampledClocks = 0;
+	profileDroppedClocks = 0;
+	profileIdleClocks = 0;
+	profileLastSample = mainCPU.clocks;
+	profileNextSample = mainCPU.clocks + PROFILE_SAMPLE_CLOCKS;
+}
+
+static void cpu6502_ProfileSample() {
+	const unsigned int sampleClocks = (unsigned int) (mainCPU.clocks - profileLastSample);
+	profileLastSample = mainCPU.clocks;
+	profileSampledClocks += sampleClocks;
+
+	cpu_profile_pc* entry = cpu6502_ProfileEntry(mainCPU.PC);
+	if (entry) {
+		entry->clocks += sampleClocks;
+	} else {
+		profileDroppedClocks += sampleClocks;
+	}
+
+	profileNextSample = mainCPU.clocks + PROFILE_SAMPLE_CLOCKS;
+}
+
+static void cpu6502_ProfileIdle(unsigned int pc, unsigned int skipped) {
+	profileIdleClocks += skipped;
+	if (cpu_profile_pc* entry = cpu6502_ProfileEntry(pc)) {
+		entry->idleClocks += skipped;
+	}
+}
+
+static int CompareProfileOps(const void* a, const void* b) {
+	const unsigned int countA = profileOpCount[*(const int*) a];
+	const unsigned int countB = profileOpCount[*(const int*) b];
+	if (countA != countB) return countA > countB ? -1 : 1;
+	return 0;
+}
+
+// sorts by bank, then by clocks descending
+static int CompareProfilePCs(const void* a, const void* b) {
+	const cpu_profile_pc* pcA = (const cpu_profile_pc*) a;
+	const cpu_profile_pc* pcB = (const cpu_profile_pc*) b;
+	const int bankA = PROFILE_KEY_BANK(pcA->key);
+	const int bankB = PROFILE_KEY_BANK(pcB->key);
+	if (bankA != bankB) return bankA < bankB ? -1 : 1;
+	if (pcA->clocks != pcB->clocks) return pcA->clocks > pcB->clocks ? -1 : 1;
+	return 0;
+}
+
+static int CompareProfileIdle(const void* a, const void* b) {
+	const cpu_profile_pc* pcA = (const cpu_profile_pc*) a;
+	const cpu_profile_pc* pcB = (const cpu_profile_pc*) b;
+	if (pcA->idleClocks != pcB->idleClocks) return pcA->idleClocks > pcB->idleClocks ? -1 : 1;
+	return 0;
+}
+
+static double ProfilePercent(unsigned long long value, unsigned long long total) {
+	return total ? value * 100.0 / total : 0.0;
+}
+
+#define PROFILE_LINE(...) { if (reportSize < sizeof(report) - 256) reportSize += sprintf(report + reportSize, __VA_ARGS__); }
+
+void cpu6502_ProfileReport() {
+	static char report[32768];
+	unsigned int reportSize = 0;
+
+	static const char* opNames[256] = { 0 };
+#define OPCODE(mode,op,str,clk,sz,page,name,spc) opNames[op] = str;
+#define FUSED_OP(fused,op1,op2,op3,str,size,latch,name) opNames[fused] = str;
+#include "6502_opcodes.inl"
+
+	// opcodes by count
+	unsigned long long totalOps = 0;
+	int ops[256];
+	for (int op = 0; op < 256; op++) {
+		totalOps += profileOpCount[op];
+		ops[op] = op;
+	}
+	qsort(ops, 256, sizeof(int), CompareProfileOps);
+
+	PROFILE_LINE("instructions %llu, sampled clocks %llu, idle loop clocks %llu (%.1f%%)\n\n",
+		totalOps, profileSampledClocks, profileIdleClocks, ProfilePercent(profileIdleClocks, profileSampledClocks));
+
+	PROFILE_LINE("%-4s %-24s %12s %7s\n", "op", "instruction", "count", "%");
+	for (int i = 0; i < PROFILE_TOP_OPCODES && profileOpCount[ops[i]]; i++) {
+		const int op = ops[i];
+		PROFILE_LINE("%02X   %-24s %12u %6.2f%%\n", op, opNames[op] ? opNames[op] : "(illegal)", profileOpCount[op], ProfilePercent(profileOpCount[op], totalOps));
+	}
+
+	// gather used PC entries, then top PCs per bank
+	static cpu_profile_pc sorted[PROFILE_PC_ENTRIES];
+	int numSorted = 0;
+	for (int i = 0; i < PROFILE_PC_ENTRIES; i++) {
+		if (profilePCs[i].key) sorted[numSorted++] = profilePCs[i];
+	}
+	qsort(sorted, numSorted, sizeof(cpu_profile_pc), CompareProfilePCs);
+
+	for (int i = 0; i < numSorted;) {
+		const int bank = PROFILE_KEY_BANK(sorted[i].key);
+		unsigned long long bankClocks = 0;
+		int bankEnd = i;
+		for (; bankEnd < numSorted && PROFILE_KEY_BANK(sorted[bankEnd].key) == bank; bankEnd++) {
+			bankClocks += sorted[bankEnd].clocks;
+		}
+
+		if (bankClocks) {
+			if (bank < 0) {
+				PROFILE_LINE("\nRAM %llu clocks (%.1f%%)\n", bankClocks, ProfilePercent(bankClocks, profileSampledClocks));
+			} else {
+				PROFILE_LINE("\nPRG bank %d %llu clocks (%.1f%%)\n", bank, bankClocks, ProfilePercent(bankClocks, profileSampledClocks));
+			}
+			PROFILE_LINE("%-6s %12s %7s\n", "pc", "clocks", "%");
+			for (int j = i; j < bankEnd && j < i + PROFILE_TOP_PER_BANK && sorted[j].clocks; j++) {
+				PROFILE_LINE("%04X   %12u %6.2f%%\n", PROFILE_KEY_PC(sorted[j].key), sorted[j].clocks, ProfilePercent(sorted[j].clocks, profileSampledClocks));
+			}
+		}
+
+		i = bankEnd;
+	}
+
+	if (profileDroppedClocks) {
+		PROFILE_LINE("\n%llu clocks at PCs past the table capacity\n", profileDroppedClocks);
+	}
+
+	// wait loops by skipped clocks
+	qsort(sorted, numSorted, sizeof(cpu_profile_pc), CompareProfileIdle);
+	PROFILE_LINE("\n%-6s %-6s %12s %7s\n", "bank", "loop", "idle clocks", "%");
+	for (int i = 0; i < numSorted && i < PROFILE_TOP_IDLE && sorted[i].idleClocks; i++) {
+		PROFILE_LINE("%-6d %04X   %12u %6.2f%%\n", PROFILE_KEY_BANK(sorted[i].key), PROFILE_KEY_PC(sorted[i].key), sorted[i].idleClocks,
+			ProfilePercent(sorted[i].idleClocks, profileSampledClocks));
+	}
+
+	// the file system needs the size up front
+	unsigned short fileName[64];
+	Bfile_StrToName_ncpy(fileName, PROFILE_REPORT_FILE, strlen(PROFILE_REPORT_FILE) + 1);
+	Bfile_DeleteEntry(fileName);
+	size_t size = reportSize;
+	if (Bfile_CreateEntry_OS(fileName, CREATEMODE_FILE, &size) == 0) {
+		int file = Bfile_OpenFile_OS(fileName, WRITE, 0);
+		if (file >= 0) {
+			Bfile_WriteFile_OS(file, report, reportSize);
+			Bfile_CloseFile_OS(file);
+		}
+	}
+}
+
+#define PROFILE_OP(op) \
+	profileOpCount[op]++; \
+	if (!CLOCKS_BEFORE(mainCPU.clocks, profileNextSample)) cpu6502_ProfileSample();
+#define PROFILE_IDLE(pc, skipped) cpu6502_ProfileIdle(pc, skipped);
+#else
+#define PROFILE_OP(op)
+#define PROFILE_IDLE(pc, skipped)
+
+void cpu6502_ProfileReset() {
+}
+
+void cpu6502_ProfileReport() {
+}
+#endif
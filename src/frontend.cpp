@@ -592,6 +592,7 @@ void nes_frontend::RenderGameBackground() {
 	nesPPU.scanlineOffset = 0;
 	nesPPU.currentBGColor = 0;
 	nesSettings.cachedTime = -1;
+	nesPPU.invalidateResolvedLines();
 
 	if (nesSettings.GetSetting(ST_Background) == 0) {
 		extern PrizmImage gfx_bg_warp;
@@ -792,7 +793,13 @@ void nes_frontend::Run() {
 
 			nesAPU.startup();
 			nesPPU.initPalette(); // allows palette/screen options to change during session
+			nesCart.allocateDecodedBanks();
+			nesPPU.allocateDecodedCHR();
+			nesPPU.allocateBGRowCache();
 			RunGameLoop();
+			nesPPU.freeBGRowCache();
+			nesPPU.freeDecodedCHR();
+			nesCart.freeDecodedBanks();
 			nesAPU.shutdown();
 
 			if (getDeviceType() == DT_CG20 && nesSettings.GetSetting(ST_OverClock) != 0) {
@@ -806,19 +813,10 @@ void nes_frontend::Run() {
 
 void nes_frontend::RunGameLoop() {
 	while (!shouldExit) {
-		cpu6502_Step();
-		if (mainCPU.clocks >= mainCPU.ppuClocks) nesPPU.step();
-		if (mainCPU.clocks >= mainCPU.apuClocks) nesAPU.step();
-
-		// both APU and PPU can trigger an immediate IRQ
-		if (mainCPU.irqMask) {
-			if ((mainCPU.irqMask & 1) && mainCPU.clocks >= mainCPU.irqClock[0]) cpu6502_IRQ(0);
-			else if ((mainCPU.irqMask & 2) && mainCPU.clocks >= mainCPU.irqClock[1]) cpu6502_IRQ(1);
-			else if ((mainCPU.irqMask & 4) && mainCPU.clocks >= mainCPU.irqClock[2]) cpu6502_IRQ(2);
-			else if ((mainCPU.irqMask & 8) && mainCPU.clocks >= mainCPU.irqClock[3]) cpu6502_IRQ(3);
-		}
+		mainCPU.runStep();
 	}
 
+	cpu6502_ProfileReport();
 	nesCart.OnPause();
 	shouldExit = false;
 }
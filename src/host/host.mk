@@ -0,0 +1,63 @@
+#---------------------------------------------------------------------------------
+# Headless host build of the emulation core, used to benchmark and regression check
+# the core on a desktop machine without the Prizm SDK.
+#
+#   make host-bench                          builds HostBench/nesizm_bench
+#   make host-bench ROM=game.nes FRAMES=600  builds and runs it on the given ROM
+#   make host-bench HOST_FLAGS=-DCPU_PROFILER=1  also writes a cpu profile to nesizm_profile.txt
+#   make host-bench HOST_FLAGS=-DCPU_TRACE_RING=1  enables -trace / -trace2txt instruction traces
+#   make host-bench ROM=game.nes FRAMES=600 HOST_RUN_FLAGS=-threaded  renders on a second thread
+#   NESIZM_SIMD=c HostBench/nesizm_bench ...    runs with the portable render kernels (or sse2, ssse3, avx2)
+#   make host-clean
+#---------------------------------------------------------------------------------
+
+HOST_BUILD	:=	HostBench
+HOST_TARGET	:=	$(HOST_BUILD)/nesizm_bench
+FRAMES		?=	600
+
+HOST_CXX	?=	g++
+HOST_LDFLAGS	?=	-pthread
+
+# emulation core only, the frontend / menus / DMA paths are replaced by src/host
+HOST_CORE	:=	6502.cpp nes_cpu.cpp nes_ppu.cpp nes_apu.cpp nes_cart.cpp nes_input.cpp \
+				nes_palette.cpp nes_savestate.cpp settings.cpp gamegenie.cpp scanline_vram.cpp
+
+HOST_SOURCES	:=	$(addprefix src/,$(HOST_CORE)) \
+					$(wildcard src/mappers/*.cpp) \
+					$(wildcard src/host/*.cpp)
+
+HOST_OFILES	:=	$(patsubst src/%.cpp,$(HOST_BUILD)/%.o,$(HOST_SOURCES))
+
+HOST_CXXFLAGS	:=	-O2 \
+					-g \
+					-Wall \
+					-Wno-switch \
+					-Wno-class-memaccess \
+					-Wno-narrowing \
+					-Wno-format-overflow \
+					-Wno-stringop-truncation \
+					-fno-rtti \
+					-fno-exceptions \
+					-std=gnu++11 \
+					-DTARGET_HOST=1 -DDEBUG=0 \
+					-iquote src -I src/host/include \
+					$(HOST_FLAGS)
+
+.PHONY: host-bench host-clean
+
+host-bench: $(HOST_TARGET)
+ifneq ($(strip $(ROM)),)
+	$(HOST_TARGET) $(ROM) $(FRAMES) $(HOST_RUN_FLAGS)
+endif
+
+$(HOST_TARGET): $(HOST_OFILES)
+	$(HOST_CXX) -o $@ $^ $(HOST_LDFLAGS)
+
+$(HOST_BUILD)/%.o: src/%.cpp
+	@mkdir -p $(dir $@)
+	$(HOST_CXX) $(HOST_CXXFLAGS) -MMD -MP -c $< -o $@
+
+host-clean:
+	rm -rf $(HOST_BUILD)
+
+-include $(HOST_OFILES:.o=.d)
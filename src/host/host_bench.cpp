@@ -0,0 +1,305 @@
+// Headless benchmark runner for the host build. Loads a .nes file, runs the game loop for a fixed number of
+// frames with no pacing, and reports emulated FPS along with per subsystem times and a hash of the final
+// state (so optimizations can be checked for output changes).
+//
+// usage: nesizm_bench <rom.nes> [frames] [-threaded] [-interlaced] [-trace <trace.bin>]
+//        nesizm_bench -trace2txt <trace.bin> <trace.txt> [-clocks]
+//        nesizm_bench -simdbench
+//        nesizm_bench -linehashtest
+//
+// -threaded renders scanlines on a second thread (see host_render_thread.h).
+// -trace dumps the instruction trace ring at the end of the run and -trace2txt converts a dump to FCEUX trace text
+// (both need a CPU_TRACE_RING build). -simdbench times the vectorized render kernels against the portable ones, and
+// NESIZM_SIMD=<c|sse2|ssse3|avx2> forces a kernel set for a run. -linehashtest checks that pixel changes built to cancel in
+// simple sums (and random ones) never match the resolved line hash
+
+#include "platform.h"
+#include "debug.h"
+#include "nes.h"
+#include "settings.h"
+#include "frontend.h"
+#include "imageDraw.h"
+#include "scope_timer/scope_timer.h"
+#include "snd/snd.h"
+#include "host_trace.h"
+#include "host_simd.h"
+#include "host_render_thread.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frontend stand-ins (menus, fonts and images are not part of the host build)
+
+bool shouldExit = false;
+nes_frontend nesFrontend;
+
+nes_frontend::nes_frontend() : MenuBGHash(0), currentOptions(nullptr), numOptions(0), selectedOption(0), selectOffset(0), gotoGame(false), faqHandle(-1), faqHash(0) {
+}
+
+void nes_frontend::ResetPressed() {
+}
+
+void nes_frontend::RenderTimeToBuffer(unsigned short* buffer) {
+	memset(buffer, 0, CLOCK_WIDTH * CLOCK_HEIGHT * 2);
+}
+
+void nes_frontend::RenderFPS(int32 fps, unsigned short* buffer) {
+	memset(buffer, 0, CLOCK_WIDTH * CLOCK_HEIGHT * 2);
+}
+
+void PrizmImage::Draw_Blit(int32 x, int32 y) const {
+}
+
+void reset_printf() {
+}
+
+void ScreenPrint(char* buffer) {
+	fputs(buffer, stdout);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Runner
+
+static uint32 HashBytes(uint32 hash, const void* data, int size) {
+	// FNV-1a
+	const uint8* bytes = (const uint8*) data;
+	for (int i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 16777619;
+	}
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Line hash self check
+
+static uint32 testRandom = 2463534242u;
+static uint32 TestRandom() {
+	// xorshift32
+	testRandom ^= testRandom << 13;
+	testRandom ^= testRandom >> 17;
+	testRandom ^= testRandom << 5;
+	return testRandom;
+}
+
+// resolves a line with the base pixels, then returns whether the changed pixels match its hash
+static bool LineHashMatches(const uint8* base, const uint8* changed) {
+	memcpy(&nesPPU.scanlineBuffer[8], base, 256);
+	nesPPU.lineUnchanged(0);
+	nesPPU.lineUnchanged(0);
+	memcpy(&nesPPU.scanlineBuffer[8], changed, 256);
+	return nesPPU.lineUnchanged(0);
+}
+
+static int CheckLineHash(const char* name, const uint8* base, const uint8* changed) {
+	const bool bMatch = LineHashMatches(base, changed);
+	printf("%-40s %s\n", name, bMatch ? "MATCH" : "ok");
+	return bMatch ? 1 : 0;
+}
+
+static void AddToWord(uint8* pixels, int word, uint32 value) {
+	uint32 w;
+	memcpy(&w, pixels + word * 4, 4);
+	w += value;
+	memcpy(pixels + word * 4, &w, 4);
+}
+
+static int LineHashTest() {
+	nesPPU.init();
+	nesPPU.scanline = 100;
+
+	static uint8 base[256];
+	static uint8 changed[256];
+	int matches = 0;
+
+	// +D / -2D / +D on adjacent words
+	for (int i = 0; i < 256; i++) {
+		base[i] = TestRandom() & 0x1F;
+	}
+	memcpy(changed, base, 256);
+	AddToWord(changed, 10, 0x01010101);
+	AddToWord(changed, 11, (uint32) -0x02020202);
+	AddToWord(changed, 12, 0x01010101);
+	matches += CheckLineHash("+D/-2D/+D adjacent words", base, changed);
+
+	// +(8<<24) and -(8<<24) on words 32 apart
+	memcpy(changed, base, 256);
+	AddToWord(changed, 5, 8 << 24);
+	AddToWord(changed, 37, (uint32) -(8 << 24));
+	matches += CheckLineHash("+/-(8<<24) on words 32 apart", base, changed);
+
+	// pixels 0, 4 and 8 of a blank line as 1,2,1 / 2,0,2 / 0,4,0
+	static const uint8 threePixels[3][3] = { { 1, 2, 1 }, { 2, 0, 2 }, { 0, 4, 0 } };
+	for (int a = 0; a < 3; a++) {
+		for (int b = a + 1; b < 3; b++) {
+			memset(base, 0, 256);
+			memset(changed, 0, 256);
+			for (int p = 0; p < 3; p++) {
+				base[p * 4] = threePixels[a][p];
+				changed[p * 4] = threePixels[b][p];
+			}
+			char name[64];
+			sprintf(name, "3 pixels %d,%d,%d vs %d,%d,%d", threePixels[a][0], threePixels[a][1], threePixels[a][2],
+				threePixels[b][0], threePixels[b][1], threePixels[b][2]);
+			matches += CheckLineHash(name, base, changed);
+		}
+	}
+
+	// random lines with 1 to 4 random pixels changed
+	const int numRandom = 1000000;
+	int randomMatches = 0;
+	for (int t = 0; t < numRandom; t++) {
+		for (int i = 0; i < 256; i++) {
+			base[i] = TestRandom() & 0x3F;
+		}
+		memcpy(changed, base, 256);
+		const int numChanges = 1 + (TestRandom() & 3);
+		for (int c = 0; c < numChanges; c++) {
+			const int x = TestRandom() & 0xFF;
+			changed[x] = (changed[x] + 1 + (TestRandom() % 0x3F)) & 0x3F;
+		}
+		// (a later change can put a pixel back)
+		if (memcmp(base, changed, 256) != 0 && LineHashMatches(base, changed)) {
+			randomMatches++;
+		}
+	}
+	printf("%-40s %d of %d\n", "random 1-4 pixel changes matching", randomMatches, numRandom);
+
+	return matches + randomMatches;
+}
+
+int main(int argc, char** argv) {
+	const char* romFile = nullptr;
+	int numFrames = 600;
+	bool bThreaded = false;
+	bool bInterlaced = false;
+	const char* traceFile = nullptr;
+
+	if (argc >= 4 && !strcmp(argv[1], "-trace2txt")) {
+		const bool bShowClocks = argc >= 5 && !strcmp(argv[4], "-clocks");
+		if (!HostTraceExport(argv[2], argv[3], bShowClocks)) {
+			fprintf(stderr, "could not convert %s (trace ring is %s in this build)\n", argv[2], CPU_TRACE_RING ? "enabled" : "disabled");
+			return 1;
+		}
+		return 0;
+	}
+
+	if (argc >= 2 && !strcmp(argv[1], "-simdbench")) {
+		HostSIMD_Benchmark();
+		return 0;
+	}
+
+	if (argc >= 2 && !strcmp(argv[1], "-linehashtest")) {
+		return LineHashTest() ? 1 : 0;
+	}
+
+	HostSIMD_Init();
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-threaded")) {
+			bThreaded = true;
+		} else if (!strcmp(argv[i], "-interlaced")) {
+			bInterlaced = true;
+		} else if (!strcmp(argv[i], "-trace") && i + 1 < argc) {
+			traceFile = argv[++i];
+		} else if (romFile == nullptr) {
+			romFile = argv[i];
+		} else {
+			numFrames = atoi(argv[i]);
+		}
+	}
+
+	if (romFile == nullptr || numFrames <= 0) {
+		fprintf(stderr, "usage: %s <rom.nes> [frames] [-threaded] [-interlaced] [-trace <trace.bin>]\n", argv[0]);
+		fprintf(stderr, "       %s -trace2txt <trace.bin> <trace.txt> [-clocks]\n", argv[0]);
+		fprintf(stderr, "       %s -simdbench\n", argv[0]);
+		fprintf(stderr, "       %s -linehashtest\n", argv[0]);
+		return 1;
+	}
+
+	// no frame skip and sound mixing enabled so every frame does the full amount of work
+	nesSettings.SetDefaults();
+	nesSettings.IncSetting(ST_FrameSkip);
+	if (bInterlaced) {
+		// on to the interlace option
+		for (int i = 0; i < 5; i++) {
+			nesSettings.IncSetting(ST_FrameSkip);
+		}
+	}
+	nesSettings.IncSetting(ST_SoundEnabled);
+
+	static unsigned char staticBanks[STATIC_CACHED_ROM_BANKS * 8192] ALIGN(256);
+	nesCart.allocateBanks(staticBanks);
+
+	cpu6502_Init();
+	nesPPU.init();
+	if (!nesCart.loadROM(romFile)) {
+		printf("\n");
+		return 1;
+	}
+	printf("\n");
+	mainCPU.reset();
+
+	nesAPU.startup();
+	nesPPU.initPalette();
+	nesCart.allocateDecodedBanks();
+	nesPPU.allocateDecodedCHR();
+	nesPPU.allocateBGRowCache();
+
+	if (bThreaded && !RenderThread_Start()) {
+		printf("render thread not available for MMC2/4 carts, rendering inline\n");
+	}
+
+	const int samplesPerFrame = SOUND_RATE / 60;
+	static int soundBuffer[SOUND_RATE / 60];
+	uint32 soundHash = 2166136261u;
+
+	ScopeTimer::InitSystem();
+	const unsigned long long startTime = ScopeTimer::GetNanoseconds();
+
+	const unsigned int targetFrame = nesPPU.frameCounter + numFrames;
+	unsigned int lastFrame = nesPPU.frameCounter;
+	while (nesPPU.frameCounter != targetFrame) {
+		mainCPU.runStep();
+
+		if (nesPPU.frameCounter != lastFrame) {
+			lastFrame = nesPPU.frameCounter;
+			sndFrame(soundBuffer, samplesPerFrame);
+			soundHash = HashBytes(soundHash, soundBuffer, sizeof(soundBuffer));
+		}
+	}
+
+	RenderThread_Stop();
+	const unsigned long long elapsed = ScopeTimer::GetNanoseconds() - startTime;
+	nesPPU.freeBGRowCache();
+	nesPPU.freeDecodedCHR();
+	nesCart.freeDecodedBanks();
+	nesAPU.shutdown();
+
+	printf("%d frames in %.3f s : %.1f emulated FPS (%.1f%% of NTSC speed)\n", numFrames, elapsed / 1000000000.0,
+		numFrames * 1000000000.0 / elapsed, numFrames * 1000000000.0 / elapsed * 100.0 / 60.0988);
+	printf("\n");
+	ScopeTimer::DisplayTimes();
+	printf("\n");
+
+	cpu6502_FusedReport();
+	printf("\n");
+
+	cpu6502_ProfileReport();
+
+	printf("idle loop clocks skipped %llu (%.1f%%)\n", mainCPU.idleClocksSkipped, mainCPU.clocks ? mainCPU.idleClocksSkipped * 100.0 / mainCPU.clocks : 0.0);
+	printf("unchanged lines skipped %u (%.1f per frame)\n", nesPPU.totalLinesSkipped, nesPPU.totalLinesSkipped / (double) numFrames);
+	printf("static frames %u (%.1f%%)\n", nesPPU.staticFrames, nesPPU.staticFrames * 100.0 / numFrames);
+	printf("catch-up spans %u (%.1f lines each)\n", nesPPU.catchUpSpans, nesPPU.catchUpSpans ? nesPPU.catchUpLines / (double) nesPPU.catchUpSpans : 0.0);
+
+	uint32 stateHash = 2166136261u;
+	stateHash = HashBytes(stateHash, GetVRAMAddress(), LCD_WIDTH_PX * LCD_HEIGHT_PX * 2);
+	stateHash = HashBytes(stateHash, mainCPU.RAM, sizeof(mainCPU.RAM));
+	printf("cpu clocks %llu, frame hash %08x, sound hash %08x\n", (unsigned long long) mainCPU.clocks, stateHash, soundHash);
+
+	if (traceFile && !HostTraceDump(traceFile)) {
+		fprintf(stderr, "could not write %s (trace ring is %s in this build)\n", traceFile, CPU_TRACE_RING ? "enabled" : "disabled");
+	}
+
+	nesCart.unload();
+	ScopeTimer::Shutdown();
+
+	return 0;
+}
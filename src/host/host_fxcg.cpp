@@ -0,0 +1,239 @@
+// POSIX implementation of the fxcg SDK stand-ins used by the headless host build
+
+#include "platform.h"
+
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// File system
+
+#define MAX_HOST_FILES 16
+
+struct host_file {
+	FILE* fp;
+
+	// whole file contents, loaded on first Bfile_GetBlockAddress request
+	unsigned char* data;
+};
+
+static host_file openFiles[MAX_HOST_FILES] = { 0 };
+
+// converts a \\fls0\dir\file.ext path into a relative posix path
+static void ResolveHostPath(const unsigned short* filename, char* intoPath, int maxLen) {
+	char fullPath[256];
+	int len = 0;
+	while (filename[len] && len < 255) {
+		fullPath[len] = (char) filename[len];
+		len++;
+	}
+	fullPath[len] = 0;
+
+	const char* path = fullPath;
+	if (!strncmp(path, "\\\\fls0\\", 7) || !strncmp(path, "\\\\dev0\\", 7)) {
+		path += 7;
+	}
+
+	int i = 0;
+	for (; path[i] && i < maxLen - 1; i++) {
+		intoPath[i] = path[i] == '\\' ? '/' : path[i];
+	}
+	intoPath[i] = 0;
+}
+
+static host_file* GetHostFile(int handle) {
+	if (handle < 0 || handle >= MAX_HOST_FILES || openFiles[handle].fp == nullptr)
+		return nullptr;
+	return &openFiles[handle];
+}
+
+void Bfile_StrToName_ncpy(unsigned short* dest, const char* source, size_t n) {
+	size_t i = 0;
+	for (; i < n && source[i]; i++) {
+		dest[i] = (unsigned char) source[i];
+	}
+	if (i < n) dest[i] = 0;
+}
+
+int Bfile_OpenFile_OS(const unsigned short* filename, int mode, int zero) {
+	char path[256];
+	ResolveHostPath(filename, path, 256);
+
+	for (int i = 0; i < MAX_HOST_FILES; i++) {
+		if (openFiles[i].fp == nullptr) {
+			openFiles[i].fp = fopen(path, mode == READ || mode == READ_SHARE ? "rb" : "r+b");
+			openFiles[i].data = nullptr;
+			return openFiles[i].fp ? i : -1;
+		}
+	}
+
+	return -1;
+}
+
+int Bfile_CloseFile_OS(int handle) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	fclose(file->fp);
+	free(file->data);
+	file->fp = nullptr;
+	file->data = nullptr;
+	return 0;
+}
+
+int Bfile_GetFileSize_OS(int handle) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	long pos = ftell(file->fp);
+	fseek(file->fp, 0, SEEK_END);
+	long size = ftell(file->fp);
+	fseek(file->fp, pos, SEEK_SET);
+	return (int) size;
+}
+
+int Bfile_ReadFile_OS(int handle, void* buf, int size, int readpos) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	if (readpos >= 0) {
+		fseek(file->fp, readpos, SEEK_SET);
+	}
+	return (int) fread(buf, 1, size, file->fp);
+}
+
+int Bfile_WriteFile_OS(int handle, const void* buf, int size) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	return (int) fwrite(buf, 1, size, file->fp);
+}
+
+int Bfile_SeekFile_OS(int handle, int pos) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	return fseek(file->fp, pos, SEEK_SET) == 0 ? pos : -1;
+}
+
+int Bfile_TellFile_OS(int handle) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	return (int) ftell(file->fp);
+}
+
+int Bfile_CreateEntry_OS(const unsigned short* filename, int mode, size_t* size) {
+	if (mode != CREATEMODE_FILE)
+		return -1;
+
+	char path[256];
+	ResolveHostPath(filename, path, 256);
+
+	// the calculator file system requires the size up front, so match it with a zero filled file
+	FILE* fp = fopen(path, "wb");
+	if (!fp)
+		return -1;
+
+	if (size && *size) {
+		fseek(fp, (long) *size - 1, SEEK_SET);
+		fputc(0, fp);
+	}
+	fclose(fp);
+	return 0;
+}
+
+int Bfile_DeleteEntry(const unsigned short* filename) {
+	char path[256];
+	ResolveHostPath(filename, path, 256);
+	return remove(path) == 0 ? 0 : -1;
+}
+
+int Bfile_GetBlockAddress(int handle, int pos, void* blockPtr) {
+	host_file* file = GetHostFile(handle);
+	if (!file)
+		return -1;
+
+	int size = Bfile_GetFileSize_OS(handle);
+	if (pos < 0 || pos >= size)
+		return -1;
+
+	// the device maps file blocks directly from flash, so keep the whole file resident
+	if (file->data == nullptr) {
+		// padded to a full block so block reads past the end of file stay in bounds
+		file->data = (unsigned char*) calloc((size + 0xFFF) & ~0xFFF, 1);
+		long oldPos = ftell(file->fp);
+		fseek(file->fp, 0, SEEK_SET);
+		if (fread(file->data, 1, size, file->fp) != (size_t) size) {
+			fseek(file->fp, oldPos, SEEK_SET);
+			return -1;
+		}
+		fseek(file->fp, oldPos, SEEK_SET);
+	}
+
+	*((unsigned char**) blockPtr) = file->data + pos;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Main memory (no stored items on host)
+
+int MCSGetDlen2(unsigned char* dir, unsigned char* item, int* data_len) {
+	*data_len = 0;
+	return 1;
+}
+
+int MCSGetData1(int offset, int len_to_copy, void* buffer) {
+	return 1;
+}
+
+int MCS_CreateDirectory(unsigned char* dir) {
+	return 0;
+}
+
+int MCS_WriteItem(unsigned char* dir, unsigned char* item, short itemtype, int data_length, size_t buffer) {
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Display, clock, and system
+
+static unsigned short hostVRAM[LCD_WIDTH_PX * LCD_HEIGHT_PX] ALIGN(4);
+
+void* GetVRAMAddress() {
+	return hostVRAM;
+}
+
+void Bdisp_PutDisp_DD() {
+}
+
+int RTC_GetTicks() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int) (now.tv_sec * 128 + now.tv_nsec / (1000000000 / 128));
+}
+
+void RTC_GetTime(unsigned int* hour, unsigned int* minute, unsigned int* second, unsigned int* millisecond) {
+	timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	tm local;
+	localtime_r(&now.tv_sec, &local);
+	*hour = local.tm_hour;
+	*minute = local.tm_min;
+	*second = local.tm_sec;
+	*millisecond = now.tv_nsec / 1000000;
+}
+
+int getDeviceType() {
+	return DT_CG50;
+}
+
+// host input, no keys are ever down
+extern "C" bool keyDown_fast(unsigned char keyCode) {
+	return false;
+}
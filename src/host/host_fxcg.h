@@ -0,0 +1,55 @@
+#pragma once
+
+// POSIX stand-ins for the subset of the fxcg SDK used by the emulation core, so the core can be built
+// and benchmarked headless on a desktop machine (see host.mk, make host-bench)
+
+#include <stddef.h>
+
+#define LCD_WIDTH_PX 384
+#define LCD_HEIGHT_PX 216
+
+#define COLOR_BLACK 0x0000
+#define COLOR_WHITE 0xFFFF
+
+// file modes
+#define READ 0
+#define READ_SHARE 1
+#define WRITE 2
+#define READWRITE 3
+#define READWRITE_SHARE 4
+
+#define CREATEMODE_FILE 1
+#define CREATEMODE_FOLDER 5
+
+// device types for getDeviceType
+#define DT_CG20 1
+#define DT_CG50 3
+
+// file system : \\fls0\ and \\dev0\ paths are resolved relative to the working directory
+void Bfile_StrToName_ncpy(unsigned short* dest, const char* source, size_t n);
+int Bfile_OpenFile_OS(const unsigned short* filename, int mode, int zero);
+int Bfile_CloseFile_OS(int handle);
+int Bfile_GetFileSize_OS(int handle);
+int Bfile_ReadFile_OS(int handle, void* buf, int size, int readpos);
+int Bfile_WriteFile_OS(int handle, const void* buf, int size);
+int Bfile_SeekFile_OS(int handle, int pos);
+int Bfile_TellFile_OS(int handle);
+int Bfile_CreateEntry_OS(const unsigned short* filename, int mode, size_t* size);
+int Bfile_DeleteEntry(const unsigned short* filename);
+int Bfile_GetBlockAddress(int handle, int pos, void* blockPtr);
+
+// main memory storage (settings), always empty on host
+int MCSGetDlen2(unsigned char* dir, unsigned char* item, int* data_len);
+int MCSGetData1(int offset, int len_to_copy, void* buffer);
+int MCS_CreateDirectory(unsigned char* dir);
+int MCS_WriteItem(unsigned char* dir, unsigned char* item, short itemtype, int data_length, size_t buffer);
+
+// display : VRAM is a plain 16 bit buffer that is never presented
+void* GetVRAMAddress();
+void Bdisp_PutDisp_DD();
+
+// rtc : 128 Hz tick counter from the monotonic clock
+int RTC_GetTicks();
+void RTC_GetTime(unsigned int* hour, unsigned int* minute, unsigned int* second, unsigned int* millisecond);
+
+int getDeviceType();
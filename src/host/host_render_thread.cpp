@@ -0,0 +1,255 @@
+// Pipelined scanline rendering on a second thread for the host build (see host_render_thread.h)
+
+// before platform.h, which defines min / max macros
+#include <atomic>
+#include <thread>
+
+#include "platform.h"
+#include "debug.h"
+#include "nes.h"
+#include "scope_timer/scope_timer.h"
+#include "host_render_thread.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPIN_PAUSE() _mm_pause()
+#else
+#define SPIN_PAUSE()
+#endif
+
+// a bit over a frame of lines, so the emulation thread can run a full frame ahead
+#define RENDER_RING_SIZE 256
+
+// PPU registers a queued scanline is rendered with
+struct render_line {
+	void(*renderScanline)(nes_ppu& ppu);
+	unsigned char* chrPages[2];
+	unsigned int scanline;
+	unsigned int frameCounter;
+	int scrollY;
+	int scanlineOffset;
+	int mirror;
+	unsigned char PPUCTRL;
+	unsigned char PPUMASK;
+	unsigned char PPUSTATUS;
+	unsigned char SCROLLX;
+	bool flipY;
+	bool causeDecrement;
+	bool bResolve;
+	bool bFinishFrame;
+	bool bSkippedFrame;
+};
+
+bool renderThreadActive = false;
+
+// render side copy of the PPU, only touched by the render thread while it has lines queued
+static nes_ppu renderPPU;
+static unsigned int renderMemoryVersion;
+
+static render_line renderRing[RENDER_RING_SIZE];
+static std::atomic<unsigned int> ringQueued(0);		// written by the emulation thread
+static std::atomic<unsigned int> ringDone(0);		// written by the render thread once a line is finished
+static std::atomic<bool> renderThreadExit(false);
+static std::thread renderThread;
+
+void nes_ppu::syncRender() {
+	if (renderThreadActive) {
+		RenderThread_Sync();
+	}
+}
+
+// spins briefly before giving up the time slice, the other thread is usually only a line or two away
+static void SpinWait(int& spins) {
+	if (++spins < 256) {
+		SPIN_PAUSE();
+	} else {
+		std::this_thread::yield();
+	}
+}
+
+static void RenderLine(const render_line& line) {
+	nes_ppu& ppu = renderPPU;
+	ppu.scanline = line.scanline;
+	ppu.frameCounter = line.frameCounter;
+
+	if (line.bFinishFrame) {
+		if (!line.bSkippedFrame) {
+			ppu.lastFrameLinesSkipped = ppu.linesSkipped;
+			ppu.linesSkipped = 0;
+		}
+
+		ppu.finishFrame(line.bSkippedFrame);
+		return;
+	}
+
+	ppu.renderScanline = line.renderScanline;
+	ppu.chrPages[0] = line.chrPages[0];
+	ppu.chrPages[1] = line.chrPages[1];
+	ppu.scrollY = line.scrollY;
+	ppu.scanlineOffset = line.scanlineOffset;
+	ppu.mirror = line.mirror;
+	ppu.PPUCTRL = line.PPUCTRL;
+	ppu.PPUMASK = line.PPUMASK;
+	ppu.SetPPUSTATUS(line.PPUSTATUS);
+	ppu.SCROLLX = line.SCROLLX;
+	ppu.flipY = line.flipY;
+	ppu.causeDecrement = line.causeDecrement;
+
+	// the scanline sprite lists are resolved on the emulation thread
+	ppu.dirtyOAM = false;
+
+	ppu.renderScanline(ppu);
+	if (line.bResolve) {
+		ppu.resolveScanline(ppu.SCROLLX & 15);
+	}
+}
+
+static void RenderThreadMain() {
+	unsigned int done = ringDone.load(std::memory_order_relaxed);
+	int spins = 0;
+	while (!renderThreadExit.load(std::memory_order_relaxed)) {
+		if (done == ringQueued.load(std::memory_order_acquire)) {
+			SpinWait(spins);
+			continue;
+		}
+
+		RenderLine(renderRing[done & (RENDER_RING_SIZE - 1)]);
+		ringDone.store(++done, std::memory_order_release);
+		spins = 0;
+	}
+}
+
+void RenderThread_Sync() {
+	TIME_SCOPE();
+
+	const unsigned int queued = ringQueued.load(std::memory_order_relaxed);
+	int spins = 0;
+	while (ringDone.load(std::memory_order_acquire) != queued) {
+		SpinWait(spins);
+	}
+}
+
+static void QueueLine(const render_line& line) {
+	const unsigned int queued = ringQueued.load(std::memory_order_relaxed);
+	int spins = 0;
+	while (queued - ringDone.load(std::memory_order_acquire) >= RENDER_RING_SIZE) {
+		SpinWait(spins);
+	}
+
+	renderRing[queued & (RENDER_RING_SIZE - 1)] = line;
+	ringQueued.store(queued + 1, std::memory_order_release);
+}
+
+// copies the memory the renderers read from nesPPU (the render thread must be idle)
+static void CopyRenderMemory() {
+	memcpy(renderPPU.nameTables, nesPPU.nameTables, sizeof(nesPPU.nameTables));
+	memcpy(renderPPU.nameTableRowVersion, nesPPU.nameTableRowVersion, sizeof(nesPPU.nameTableRowVersion));
+	renderPPU.bgRowCacheVersion = nesPPU.bgRowCacheVersion;
+	memcpy(renderPPU.oam, nesPPU.oam, sizeof(nesPPU.oam));
+	memcpy(renderPPU.workingPalette, nesPPU.workingPalette, sizeof(nesPPU.workingPalette));
+	renderPPU.workingPaletteHash = nesPPU.workingPaletteHash;
+	renderMemoryVersion = nesPPU.renderMemoryVersion;
+}
+
+bool RenderThread_Start() {
+	// MMC2/4 latches switch CHR banks while rendering
+	if (renderThreadActive || nesCart.renderLatch) {
+		return false;
+	}
+
+	memcpy(&renderPPU, &nesPPU, sizeof(nes_ppu));
+	CopyRenderMemory();
+
+	renderThreadExit = false;
+	renderThread = std::thread(RenderThreadMain);
+	renderThreadActive = true;
+	return true;
+}
+
+void RenderThread_Stop() {
+	if (!renderThreadActive)
+		return;
+
+	RenderThread_Sync();
+	renderThreadExit = true;
+	renderThread.join();
+	renderThreadActive = false;
+
+	nesPPU.lastFrameLinesSkipped = renderPPU.lastFrameLinesSkipped;
+	nesPPU.totalLinesSkipped = renderPPU.totalLinesSkipped;
+
+	// nesPPU's hashes are stale since it hasn't resolved anything
+	nesPPU.invalidateResolvedLines();
+}
+
+void RenderThread_Scanline(bool bResolve) {
+	nes_ppu& ppu = nesPPU;
+
+	// the scanline sprite lists and working palette are resolved here so the render thread only reads them
+	if (ppu.dirtyOAM) {
+		ppu.resolveOAMExternal();
+	}
+	if (bResolve && ppu.dirtyPalette) {
+		ppu.resolveWorkingPalette();
+		ppu.renderMemoryVersion++;
+	}
+
+	// lines that may hit sprite 0 or decrement the scroll are rendered here once the queue is empty, since emulation
+	// depends on them (the rest only render lines before and after the resolved ones for sprite 0)
+	const bool bRenderHere = ppu.lineAffectsEmulation();
+	if (!bResolve && !bRenderHere) {
+		return;
+	}
+
+	if (bRenderHere || ppu.renderMemoryVersion != renderMemoryVersion) {
+		RenderThread_Sync();
+		if (ppu.renderMemoryVersion != renderMemoryVersion) {
+			CopyRenderMemory();
+		}
+	}
+
+	render_line line;
+	line.renderScanline = ppu.renderScanline;
+	line.chrPages[0] = ppu.chrPages[0];
+	line.chrPages[1] = ppu.chrPages[1];
+	line.scanline = ppu.scanline;
+	line.frameCounter = ppu.frameCounter;
+	line.scrollY = ppu.scrollY;
+	line.scanlineOffset = ppu.scanlineOffset;
+	line.mirror = ppu.mirror;
+	line.PPUCTRL = ppu.PPUCTRL;
+	line.PPUMASK = ppu.PPUMASK;
+	line.PPUSTATUS = ppu.PPUSTATUS;
+	line.SCROLLX = ppu.SCROLLX;
+	line.flipY = ppu.flipY;
+	line.causeDecrement = ppu.causeDecrement;
+	line.bResolve = bResolve;
+	line.bFinishFrame = false;
+	line.bSkippedFrame = false;
+
+	if (bRenderHere) {
+		RenderLine(line);
+		ppu.SetPPUSTATUS(ppu.PPUSTATUS | (renderPPU.PPUSTATUS & PPUSTAT_SPRITE0));
+		ppu.scrollY = renderPPU.scrollY;
+	} else {
+		QueueLine(line);
+	}
+}
+
+void RenderThread_FinishFrame(bool bSkippedFrame) {
+	render_line line;
+	memset(&line, 0, sizeof(line));
+	line.scanline = nesPPU.scanline;
+	line.frameCounter = nesPPU.frameCounter;
+	line.bFinishFrame = true;
+	line.bSkippedFrame = bSkippedFrame;
+	QueueLine(line);
+}
+
+void RenderThread_InvalidateResolvedLines() {
+	if (!renderThreadActive)
+		return;
+
+	RenderThread_Sync();
+	renderPPU.invalidateResolvedLines();
+}
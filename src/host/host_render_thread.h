@@ -0,0 +1,31 @@
+#pragma once
+
+// Pipelined rendering for the host build. The emulation thread queues a snapshot of the PPU registers for each
+// rendered scanline into a lock free ring, and a second thread renders and resolves them from its own copy of the
+// PPU, so a frame costs about the larger of the CPU and render times instead of their sum.
+//
+// The render copy takes nametable, OAM and working palette memory from nesPPU whenever nesPPU.renderMemoryVersion
+// changes (waiting for queued lines first), so the emulation thread only has to wait when it changes memory the
+// render thread reads directly (see nes_ppu::syncRender). Lines that may cause a sprite 0 hit or change scroll are
+// rendered on the emulation thread once the queue drains, since emulation depends on their results.
+
+// true between RenderThread_Start and RenderThread_Stop
+extern bool renderThreadActive;
+
+// starts the render thread, returns false if the cart can't pipeline rendering (MMC2/4 render latches)
+bool RenderThread_Start();
+
+// waits for queued lines and stops the render thread, copying render statistics back to nesPPU
+void RenderThread_Stop();
+
+// renders the current nesPPU scanline (resolving it to the screen if bResolve), usually queued to the render thread
+void RenderThread_Scanline(bool bResolve);
+
+// queues the end of the frame (finishFrame) after the lines already queued
+void RenderThread_FinishFrame(bool bSkippedFrame);
+
+// waits until every queued line is rendered
+void RenderThread_Sync();
+
+// invalidates the resolved line hashes of the render copy
+void RenderThread_InvalidateResolvedLines();
@@ -0,0 +1,94 @@
+// Host implementation of the scope_timer stand-in (see include/scope_timer/scope_timer.h)
+
+// before platform.h, which defines min / max macros
+#include <mutex>
+
+#include "platform.h"
+#include "scope_timer/scope_timer.h"
+
+#include <time.h>
+
+ScopeTimer* ScopeTimer::firstTimer = nullptr;
+
+static unsigned long long systemStart = 0;
+static unsigned int framesReported = 0;
+
+ScopeTimer::ScopeTimer(const char* withName, int withLine) : name(nullptr), totalNanoseconds(0), count(0), next(nullptr) {
+	Register(withName);
+}
+
+void ScopeTimer::Register(const char* withName) {
+	// timers may first be used from the render thread (host_render_thread.h)
+	static std::mutex registerMutex;
+	std::lock_guard<std::mutex> lock(registerMutex);
+
+	if (name == nullptr) {
+		next = firstTimer;
+		firstTimer = this;
+	}
+	name = withName;
+}
+
+unsigned long long ScopeTimer::GetNanoseconds() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+void ScopeTimer::InitSystem() {
+	for (ScopeTimer* timer = firstTimer; timer; timer = timer->next) {
+		timer->totalNanoseconds = 0;
+		timer->count = 0;
+	}
+
+	systemStart = GetNanoseconds();
+	framesReported = 0;
+}
+
+void ScopeTimer::ReportFrame() {
+	framesReported++;
+}
+
+void ScopeTimer::DisplayTimes() {
+	const unsigned long long elapsed = GetNanoseconds() - systemStart;
+	if (elapsed == 0)
+		return;
+
+	// selection sort by total time, the list is short
+	ScopeTimer* sorted[64];
+	int numTimers = 0;
+	for (ScopeTimer* timer = firstTimer; timer && numTimers < 64; timer = timer->next) {
+		if (timer->count) sorted[numTimers++] = timer;
+	}
+	for (int i = 0; i < numTimers; i++) {
+		for (int j = i + 1; j < numTimers; j++) {
+			if (sorted[j]->totalNanoseconds > sorted[i]->totalNanoseconds) {
+				ScopeTimer* swap = sorted[i];
+				sorted[i] = sorted[j];
+				sorted[j] = swap;
+			}
+		}
+	}
+
+	printf("%-28s %10s %7s %10s %10s\n", "scope (inclusive)", "total ms", "%", "calls", "us/frame");
+	for (int i = 0; i < numTimers; i++) {
+		// named scopes may be stringized string literals
+		char name[64];
+		const char* src = sorted[i]->name;
+		int len = 0;
+		for (; *src && len < 63; src++) {
+			if (*src != '"') name[len++] = *src;
+		}
+		name[len] = 0;
+
+		printf("%-28s %10.2f %6.2f%% %10u %10.2f\n",
+			name,
+			sorted[i]->totalNanoseconds / 1000000.0,
+			sorted[i]->totalNanoseconds * 100.0 / elapsed,
+			sorted[i]->count,
+			framesReported ? sorted[i]->totalNanoseconds / 1000.0 / framesReported : 0.0);
+	}
+}
+
+void ScopeTimer::Shutdown() {
+}
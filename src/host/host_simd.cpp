@@ -0,0 +1,461 @@
+// Vectorized tile decode and palette resolve kernels for the host build (see host_simd.h)
+
+#include "platform.h"
+#include "scope_timer/scope_timer.h"
+#include "host_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOST_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define HOST_SIMD_X86 0
+#endif
+
+// the stretch modes expand the palette indices into a padded line first then resolve that
+#define LINE_43_WIDTH 300
+#define LINE_WIDE_WIDTH 360
+#define EXPANDED_LINE_SIZE 384
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Portable kernels (same as the WinSim paths in scanline_vram.cpp)
+
+// each bit of a byte spread to a byte of 0 or 1, first pixel in the low byte
+static unsigned long long spreadTable[256];
+
+static void BuildSpreadTable() {
+	for (int b = 0; b < 256; b++) {
+		unsigned long long spread = 0;
+		for (int bit = 0; bit < 8; bit++) {
+			if (b & (0x80 >> bit)) spread |= 1ull << (bit * 8);
+		}
+		spreadTable[b] = spread;
+	}
+}
+
+static void DecodeTiles_C(const uint8* chr, uint8* decoded, int numTiles) {
+	if (spreadTable[255] == 0) {
+		BuildSpreadTable();
+	}
+
+	for (int t = 0; t < numTiles; t++, chr += 16) {
+		for (int row = 0; row < 8; row++, decoded += 8) {
+			const unsigned long long pixels = (spreadTable[chr[row]] << 1) | (spreadTable[chr[row + 8]] << 2);
+			memcpy(decoded, &pixels, 8);
+		}
+	}
+}
+
+static void ResolveLine_C(const uint8* src, const uint16* palette, uint16* dest) {
+	for (int i = 0; i < 240; i++) {
+		*(dest++) = palette[(*src++) >> 1];
+	}
+}
+
+static void ResolveLine43_C(const uint8* src, const uint16* palette, uint16* dest, int interlacePixel) {
+	for (int i = 0; i < 60; i++) {
+		const uint16 pixels[4] = {
+			palette[src[0] >> 1],
+			palette[src[1] >> 1],
+			palette[src[2] >> 1],
+			palette[src[3] >> 1]
+		};
+		src += 4;
+		const uint16* pixel = pixels;
+		for (int j = 0; j < 5; j++) {
+			*(dest++) = *pixel;
+			if (j != interlacePixel) pixel++;
+		}
+	}
+}
+
+static void ResolveLineWide_C(const uint8* src, const uint16* palette, uint16* dest, bool bInterlace) {
+	for (int i = 0; i < 120; i++) {
+		const uint16 pixel1 = palette[(*src++) >> 1];
+		const uint16 pixel2 = palette[(*src++) >> 1];
+		*(dest++) = pixel1;
+		*(dest++) = bInterlace ? pixel1 : pixel2;
+		*(dest++) = pixel2;
+	}
+}
+
+static const host_simd_kernels portableKernels = { "c", DecodeTiles_C, ResolveLine_C, ResolveLine43_C, ResolveLineWide_C };
+
+host_simd_kernels hostKernels = portableKernels;
+
+#if HOST_SIMD_X86
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SSE2 : bit plane interleave
+
+// pixel bit masks, first pixel is the high bit
+#define PIXEL_BIT_MASKS 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+
+__attribute__((target("sse2")))
+static FORCE_INLINE __m128i InterleaveRows_SSE2(__m128i plane0, __m128i plane1, __m128i mask) {
+	const __m128i bit0 = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(plane0, mask), mask), _mm_set1_epi8(2));
+	const __m128i bit1 = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(plane1, mask), mask), _mm_set1_epi8(4));
+	return _mm_or_si128(bit0, bit1);
+}
+
+__attribute__((target("sse2")))
+static void DecodeTiles_SSE2(const uint8* chr, uint8* decoded, int numTiles) {
+	const __m128i mask = _mm_setr_epi8(PIXEL_BIT_MASKS, PIXEL_BIT_MASKS);
+	for (int t = 0; t < numTiles; t++, chr += 16, decoded += 64) {
+		// broadcast each row byte of both planes across 8 bytes, two rows per register
+		const __m128i planes = _mm_loadu_si128((const __m128i*) chr);
+		const __m128i plane0 = _mm_unpacklo_epi8(planes, planes);
+		const __m128i plane1 = _mm_unpackhi_epi8(planes, planes);
+		const __m128i plane0Lo = _mm_unpacklo_epi16(plane0, plane0);
+		const __m128i plane0Hi = _mm_unpackhi_epi16(plane0, plane0);
+		const __m128i plane1Lo = _mm_unpacklo_epi16(plane1, plane1);
+		const __m128i plane1Hi = _mm_unpackhi_epi16(plane1, plane1);
+
+		__m128i* dest = (__m128i*) decoded;
+		_mm_storeu_si128(dest + 0, InterleaveRows_SSE2(_mm_unpacklo_epi32(plane0Lo, plane0Lo), _mm_unpacklo_epi32(plane1Lo, plane1Lo), mask));
+		_mm_storeu_si128(dest + 1, InterleaveRows_SSE2(_mm_unpackhi_epi32(plane0Lo, plane0Lo), _mm_unpackhi_epi32(plane1Lo, plane1Lo), mask));
+		_mm_storeu_si128(dest + 2, InterleaveRows_SSE2(_mm_unpacklo_epi32(plane0Hi, plane0Hi), _mm_unpacklo_epi32(plane1Hi, plane1Hi), mask));
+		_mm_storeu_si128(dest + 3, InterleaveRows_SSE2(_mm_unpackhi_epi32(plane0Hi, plane0Hi), _mm_unpackhi_epi32(plane1Hi, plane1Hi), mask));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SSSE3 : palette resolve with byte shuffles over the split low / high palette bytes
+
+struct palette_tables {
+	__m128i lo[2];
+	__m128i hi[2];
+};
+
+__attribute__((target("ssse3")))
+static FORCE_INLINE void LoadPaletteTables(const uint16* palette, palette_tables& tables) {
+	ALIGN(16) uint8 lo[32];
+	ALIGN(16) uint8 hi[32];
+	for (int i = 0; i < 32; i++) {
+		lo[i] = palette[i] & 0xFF;
+		hi[i] = palette[i] >> 8;
+	}
+	tables.lo[0] = _mm_load_si128((const __m128i*) lo);
+	tables.lo[1] = _mm_load_si128((const __m128i*) (lo + 16));
+	tables.hi[0] = _mm_load_si128((const __m128i*) hi);
+	tables.hi[1] = _mm_load_si128((const __m128i*) (hi + 16));
+}
+
+// 16 pixels, the shuffle zeroes lanes with the high bit set so each half of the palette only answers for its own indices
+__attribute__((target("ssse3")))
+static FORCE_INLINE void Resolve16_SSSE3(const uint8* src, const palette_tables& tables, uint16* dest) {
+	const __m128i index = _mm_and_si128(_mm_srli_epi16(_mm_loadu_si128((const __m128i*) src), 1), _mm_set1_epi8(0x1F));
+	const __m128i select0 = _mm_adds_epu8(index, _mm_set1_epi8(0x70));
+	const __m128i select1 = _mm_sub_epi8(index, _mm_set1_epi8(0x10));
+	const __m128i lo = _mm_or_si128(_mm_shuffle_epi8(tables.lo[0], select0), _mm_shuffle_epi8(tables.lo[1], select1));
+	const __m128i hi = _mm_or_si128(_mm_shuffle_epi8(tables.hi[0], select0), _mm_shuffle_epi8(tables.hi[1], select1));
+	_mm_storeu_si128((__m128i*) dest, _mm_unpacklo_epi8(lo, hi));
+	_mm_storeu_si128((__m128i*) (dest + 8), _mm_unpackhi_epi8(lo, hi));
+}
+
+__attribute__((target("ssse3")))
+static void ResolvePixels_SSSE3(const uint8* src, const uint16* palette, uint16* dest, int numPixels) {
+	palette_tables tables;
+	LoadPaletteTables(palette, tables);
+
+	for (; numPixels >= 16; numPixels -= 16, src += 16, dest += 16) {
+		Resolve16_SSSE3(src, tables, dest);
+	}
+	for (; numPixels; numPixels--) {
+		*(dest++) = palette[(*src++) >> 1];
+	}
+}
+
+// shuffle masks expanding 12 indices to 15 (the 16th byte is overwritten by the next group)
+static ALIGN(16) uint8 expand43Masks[4][16];
+
+// shuffle masks expanding 10 indices to 15 for the wide stretch, without and with interlace
+static ALIGN(16) uint8 expandWideMasks[2][16];
+
+static void BuildExpandMasks() {
+	for (int interlacePixel = 0; interlacePixel < 4; interlacePixel++) {
+		int out = 0;
+		for (int group = 0; group < 3; group++) {
+			int pixel = group * 4;
+			for (int j = 0; j < 5; j++) {
+				expand43Masks[interlacePixel][out++] = pixel;
+				if (j != interlacePixel) pixel++;
+			}
+		}
+		expand43Masks[interlacePixel][15] = 0x80;
+	}
+
+	for (int interlace = 0; interlace < 2; interlace++) {
+		int out = 0;
+		for (int pair = 0; pair < 5; pair++) {
+			expandWideMasks[interlace][out++] = pair * 2;
+			expandWideMasks[interlace][out++] = pair * 2 + (interlace ? 0 : 1);
+			expandWideMasks[interlace][out++] = pair * 2 + 1;
+		}
+		expandWideMasks[interlace][15] = 0x80;
+	}
+}
+
+// expands the 240 indices to the stretched width in groups, each 16 byte load and store overlapping the next
+__attribute__((target("ssse3")))
+static FORCE_INLINE void ExpandLine_SSSE3(const uint8* src, uint8* expanded, const uint8* maskBytes, int srcGroup) {
+	const __m128i mask = _mm_load_si128((const __m128i*) maskBytes);
+	ALIGN(16) uint8 srcPadded[256];
+	memcpy(srcPadded, src, 240);
+	for (int i = 0; i < 240; i += srcGroup, expanded += 15) {
+		_mm_storeu_si128((__m128i*) expanded, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (srcPadded + i)), mask));
+	}
+}
+
+__attribute__((target("ssse3")))
+static void ResolveLine_SSSE3(const uint8* src, const uint16* palette, uint16* dest) {
+	ResolvePixels_SSSE3(src, palette, dest, 240);
+}
+
+__attribute__((target("ssse3")))
+static void ResolveLine43_SSSE3(const uint8* src, const uint16* palette, uint16* dest, int interlacePixel) {
+	ALIGN(16) uint8 expanded[EXPANDED_LINE_SIZE];
+	ExpandLine_SSSE3(src, expanded, expand43Masks[interlacePixel], 12);
+	ResolvePixels_SSSE3(expanded, palette, dest, LINE_43_WIDTH);
+}
+
+__attribute__((target("ssse3")))
+static void ResolveLineWide_SSSE3(const uint8* src, const uint16* palette, uint16* dest, bool bInterlace) {
+	ALIGN(16) uint8 expanded[EXPANDED_LINE_SIZE];
+	ExpandLine_SSSE3(src, expanded, expandWideMasks[bInterlace], 10);
+	ResolvePixels_SSSE3(expanded, palette, dest, LINE_WIDE_WIDTH);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2 : the same kernels two tiles / 32 pixels at a time (in lane operations with a cross lane fix up)
+
+__attribute__((target("avx2")))
+static FORCE_INLINE __m256i InterleaveRows_AVX2(__m256i plane0, __m256i plane1, __m256i mask) {
+	const __m256i bit0 = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(plane0, mask), mask), _mm256_set1_epi8(2));
+	const __m256i bit1 = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(plane1, mask), mask), _mm256_set1_epi8(4));
+	return _mm256_or_si256(bit0, bit1);
+}
+
+__attribute__((target("avx2")))
+static void DecodeTiles_AVX2(const uint8* chr, uint8* decoded, int numTiles) {
+	const __m256i mask = _mm256_setr_epi8(PIXEL_BIT_MASKS, PIXEL_BIT_MASKS, PIXEL_BIT_MASKS, PIXEL_BIT_MASKS);
+	for (; numTiles >= 2; numTiles -= 2, chr += 32, decoded += 128) {
+		// one tile per lane
+		const __m256i planes = _mm256_loadu_si256((const __m256i*) chr);
+		const __m256i plane0 = _mm256_unpacklo_epi8(planes, planes);
+		const __m256i plane1 = _mm256_unpackhi_epi8(planes, planes);
+		const __m256i plane0Lo = _mm256_unpacklo_epi16(plane0, plane0);
+		const __m256i plane0Hi = _mm256_unpackhi_epi16(plane0, plane0);
+		const __m256i plane1Lo = _mm256_unpacklo_epi16(plane1, plane1);
+		const __m256i plane1Hi = _mm256_unpackhi_epi16(plane1, plane1);
+
+		const __m256i rows01 = InterleaveRows_AVX2(_mm256_unpacklo_epi32(plane0Lo, plane0Lo), _mm256_unpacklo_epi32(plane1Lo, plane1Lo), mask);
+		const __m256i rows23 = InterleaveRows_AVX2(_mm256_unpackhi_epi32(plane0Lo, plane0Lo), _mm256_unpackhi_epi32(plane1Lo, plane1Lo), mask);
+		const __m256i rows45 = InterleaveRows_AVX2(_mm256_unpacklo_epi32(plane0Hi, plane0Hi), _mm256_unpacklo_epi32(plane1Hi, plane1Hi), mask);
+		const __m256i rows67 = InterleaveRows_AVX2(_mm256_unpackhi_epi32(plane0Hi, plane0Hi), _mm256_unpackhi_epi32(plane1Hi, plane1Hi), mask);
+
+		__m256i* dest = (__m256i*) decoded;
+		_mm256_storeu_si256(dest + 0, _mm256_permute2x128_si256(rows01, rows23, 0x20));
+		_mm256_storeu_si256(dest + 1, _mm256_permute2x128_si256(rows45, rows67, 0x20));
+		_mm256_storeu_si256(dest + 2, _mm256_permute2x128_si256(rows01, rows23, 0x31));
+		_mm256_storeu_si256(dest + 3, _mm256_permute2x128_si256(rows45, rows67, 0x31));
+	}
+
+	if (numTiles) {
+		DecodeTiles_SSE2(chr, decoded, numTiles);
+	}
+}
+
+__attribute__((target("avx2")))
+static void ResolvePixels_AVX2(const uint8* src, const uint16* palette, uint16* dest, int numPixels) {
+	palette_tables tables;
+	LoadPaletteTables(palette, tables);
+	const __m256i lo0 = _mm256_broadcastsi128_si256(tables.lo[0]);
+	const __m256i lo1 = _mm256_broadcastsi128_si256(tables.lo[1]);
+	const __m256i hi0 = _mm256_broadcastsi128_si256(tables.hi[0]);
+	const __m256i hi1 = _mm256_broadcastsi128_si256(tables.hi[1]);
+
+	for (; numPixels >= 32; numPixels -= 32, src += 32, dest += 32) {
+		const __m256i index = _mm256_and_si256(_mm256_srli_epi16(_mm256_loadu_si256((const __m256i*) src), 1), _mm256_set1_epi8(0x1F));
+		const __m256i select0 = _mm256_adds_epu8(index, _mm256_set1_epi8(0x70));
+		const __m256i select1 = _mm256_sub_epi8(index, _mm256_set1_epi8(0x10));
+		const __m256i lo = _mm256_or_si256(_mm256_shuffle_epi8(lo0, select0), _mm256_shuffle_epi8(lo1, select1));
+		const __m256i hi = _mm256_or_si256(_mm256_shuffle_epi8(hi0, select0), _mm256_shuffle_epi8(hi1, select1));
+
+		// unpacks give pixels 0-7 / 16-23 and 8-15 / 24-31 per lane
+		const __m256i pixelsLo = _mm256_unpacklo_epi8(lo, hi);
+		const __m256i pixelsHi = _mm256_unpackhi_epi8(lo, hi);
+		_mm256_storeu_si256((__m256i*) dest, _mm256_permute2x128_si256(pixelsLo, pixelsHi, 0x20));
+		_mm256_storeu_si256((__m256i*) (dest + 16), _mm256_permute2x128_si256(pixelsLo, pixelsHi, 0x31));
+	}
+	for (; numPixels >= 16; numPixels -= 16, src += 16, dest += 16) {
+		Resolve16_SSSE3(src, tables, dest);
+	}
+	for (; numPixels; numPixels--) {
+		*(dest++) = palette[(*src++) >> 1];
+	}
+}
+
+__attribute__((target("avx2")))
+static void ResolveLine_AVX2(const uint8* src, const uint16* palette, uint16* dest) {
+	ResolvePixels_AVX2(src, palette, dest, 240);
+}
+
+__attribute__((target("avx2")))
+static void ResolveLine43_AVX2(const uint8* src, const uint16* palette, uint16* dest, int interlacePixel) {
+	ALIGN(32) uint8 expanded[EXPANDED_LINE_SIZE];
+	ExpandLine_SSSE3(src, expanded, expand43Masks[interlacePixel], 12);
+	ResolvePixels_AVX2(expanded, palette, dest, LINE_43_WIDTH);
+}
+
+__attribute__((target("avx2")))
+static void ResolveLineWide_AVX2(const uint8* src, const uint16* palette, uint16* dest, bool bInterlace) {
+	ALIGN(32) uint8 expanded[EXPANDED_LINE_SIZE];
+	ExpandLine_SSSE3(src, expanded, expandWideMasks[bInterlace], 10);
+	ResolvePixels_AVX2(expanded, palette, dest, LINE_WIDE_WIDTH);
+}
+
+// best first
+static const host_simd_kernels simdKernels[] = {
+	{ "avx2", DecodeTiles_AVX2, ResolveLine_AVX2, ResolveLine43_AVX2, ResolveLineWide_AVX2 },
+	{ "ssse3", DecodeTiles_SSE2, ResolveLine_SSSE3, ResolveLine43_SSSE3, ResolveLineWide_SSSE3 },
+	{ "sse2", DecodeTiles_SSE2, ResolveLine_C, ResolveLine43_C, ResolveLineWide_C },
+};
+
+static bool KernelsSupported(const host_simd_kernels& kernels) {
+	// the builtin only takes literals
+	__builtin_cpu_init();
+	if (!strcmp(kernels.name, "avx2")) return __builtin_cpu_supports("avx2");
+	if (!strcmp(kernels.name, "ssse3")) return __builtin_cpu_supports("ssse3");
+	return __builtin_cpu_supports("sse2");
+}
+
+static const int numSIMDKernels = sizeof(simdKernels) / sizeof(simdKernels[0]);
+#else
+static const host_simd_kernels* simdKernels = nullptr;
+static const int numSIMDKernels = 0;
+
+static bool KernelsSupported(const host_simd_kernels& kernels) {
+	return false;
+}
+
+static void BuildExpandMasks() {
+}
+#endif
+
+void HostSIMD_Init() {
+	BuildSpreadTable();
+	BuildExpandMasks();
+
+	const char* forced = getenv("NESIZM_SIMD");
+	hostKernels = portableKernels;
+	for (int i = numSIMDKernels - 1; i >= 0; i--) {
+		if (!KernelsSupported(simdKernels[i]))
+			continue;
+
+		if (forced ? !strcmp(forced, simdKernels[i].name) : true) {
+			hostKernels = simdKernels[i];
+		}
+	}
+
+	if (forced && strcmp(forced, hostKernels.name)) {
+		fprintf(stderr, "NESIZM_SIMD=%s is not supported, using %s kernels\n", forced, hostKernels.name);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Microbenchmark
+
+static const int benchIterations = 20000;
+
+// runs each kernel on the same data, returns the nanoseconds per call for decoding a full 8 KB bank and per line for
+// each resolve, and a hash of all of the outputs
+static uint32 BenchKernels(const host_simd_kernels& kernels, const uint8* chr, const uint8* line, const uint16* palette, double times[4]) {
+	static uint8 decoded[512 * 64];
+	static uint16 dest[EXPANDED_LINE_SIZE];
+	uint32 hash = 2166136261u;
+	auto hashBytes = [&hash](const void* data, int size) {
+		for (int i = 0; i < size; i++) {
+			hash = (hash ^ ((const uint8*) data)[i]) * 16777619;
+		}
+	};
+
+	unsigned long long start = ScopeTimer::GetNanoseconds();
+	for (int i = 0; i < benchIterations / 64; i++) {
+		kernels.decodeTiles(chr, decoded, 512);
+	}
+	times[0] = (ScopeTimer::GetNanoseconds() - start) / double(benchIterations / 64);
+	hashBytes(decoded, sizeof(decoded));
+
+	start = ScopeTimer::GetNanoseconds();
+	for (int i = 0; i < benchIterations; i++) {
+		kernels.resolveLine(line + (i & 7), palette, dest);
+	}
+	times[1] = (ScopeTimer::GetNanoseconds() - start) / double(benchIterations);
+	hashBytes(dest, 240 * 2);
+
+	start = ScopeTimer::GetNanoseconds();
+	for (int i = 0; i < benchIterations; i++) {
+		kernels.resolveLine43(line + (i & 7), palette, dest, i & 3);
+	}
+	times[2] = (ScopeTimer::GetNanoseconds() - start) / double(benchIterations);
+	for (int i = 0; i < 4; i++) {
+		kernels.resolveLine43(line, palette, dest, i);
+		hashBytes(dest, LINE_43_WIDTH * 2);
+	}
+
+	start = ScopeTimer::GetNanoseconds();
+	for (int i = 0; i < benchIterations; i++) {
+		kernels.resolveLineWide(line + (i & 7), palette, dest, i & 1);
+	}
+	times[3] = (ScopeTimer::GetNanoseconds() - start) / double(benchIterations);
+	for (int i = 0; i < 2; i++) {
+		kernels.resolveLineWide(line, palette, dest, i != 0);
+		hashBytes(dest, LINE_WIDE_WIDTH * 2);
+	}
+
+	return hash;
+}
+
+void HostSIMD_Benchmark() {
+	HostSIMD_Init();
+
+	// random tiles, and a line of palette indices in the scanline buffer form (index << 1, low bit unused)
+	static uint8 chr[8192];
+	static uint8 line[256];
+	static uint16 palette[32];
+	uint32 seed = 12345;
+	for (int i = 0; i < 8192; i++) {
+		seed = seed * 1103515245 + 12345;
+		chr[i] = seed >> 16;
+	}
+	for (int i = 0; i < 256; i++) {
+		seed = seed * 1103515245 + 12345;
+		line[i] = (seed >> 16) & 0x3F;
+	}
+	for (int i = 0; i < 32; i++) {
+		seed = seed * 1103515245 + 12345;
+		palette[i] = seed >> 16;
+	}
+
+	printf("%-8s %14s %14s %14s %14s\n", "kernels", "decode (bank)", "resolve", "resolve 4:3", "resolve wide");
+
+	double portableTimes[4];
+	const uint32 portableHash = BenchKernels(portableKernels, chr, line, palette, portableTimes);
+	printf("%-8s %11.0f ns %11.1f ns %11.1f ns %11.1f ns\n", portableKernels.name, portableTimes[0], portableTimes[1], portableTimes[2], portableTimes[3]);
+
+	for (int i = 0; i < numSIMDKernels; i++) {
+		if (!KernelsSupported(simdKernels[i])) {
+			printf("%-8s not supported\n", simdKernels[i].name);
+			continue;
+		}
+
+		double times[4];
+		const uint32 hash = BenchKernels(simdKernels[i], chr, line, palette, times);
+		printf("%-8s %7.0f (%3.1fx) %7.1f (%3.1fx) %7.1f (%3.1fx) %7.1f (%3.1fx)%s\n", simdKernels[i].name,
+			times[0], portableTimes[0] / times[0], times[1], portableTimes[1] / times[1],
+			times[2], portableTimes[2] / times[2], times[3], portableTimes[3] / times[3],
+			hash == portableHash ? "" : "  OUTPUT MISMATCH");
+	}
+
+	printf("selected: %s\n", hostKernels.name);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// vectorized kernels for the C rendering paths of the host build (the device uses the SH4 assembly in src/asm), with a
+// set per instruction set selected at startup for the running CPU
+
+// interleaves the two bit planes of CHR tiles (16 bytes each) into rows of 8 pixels (DECODED_CHR_TILE_SIZE bytes per
+// tile), each pixel the 2 bit color index pre-shifted for the palette OR
+typedef void(*host_decode_tiles)(const uint8* chr, uint8* decoded, int numTiles);
+
+// resolves a line of 240 palette index pixels (as in scanlineBuffer, index << 1) to RGB565
+typedef void(*host_resolve_line)(const uint8* src, const uint16* palette, uint16* dest);
+
+// resolve stretched to 4:3, every 4 pixels become 5 by doubling the one at interlacePixel (0-3)
+typedef void(*host_resolve_line_43)(const uint8* src, const uint16* palette, uint16* dest, int interlacePixel);
+
+// resolve stretched wide, every 2 pixels become 3 with the middle one from the first or (bInterlace) second
+typedef void(*host_resolve_line_wide)(const uint8* src, const uint16* palette, uint16* dest, bool bInterlace);
+
+struct host_simd_kernels {
+	const char* name;
+	host_decode_tiles decodeTiles;
+	host_resolve_line resolveLine;
+	host_resolve_line_43 resolveLine43;
+	host_resolve_line_wide resolveLineWide;
+};
+
+// selected kernels, the portable set until HostSIMD_Init
+extern host_simd_kernels hostKernels;
+
+// selects the best kernel set supported by the CPU, or the named one from NESIZM_SIMD (c, sse2, ssse3, avx2)
+void HostSIMD_Init();
+
+// times each supported kernel set against the portable one and checks they produce the same output
+void HostSIMD_Benchmark();
@@ -0,0 +1,118 @@
+// Binary instruction trace dump and FCEUX text conversion for the host build (see host_trace.h)
+
+#include "platform.h"
+#include "6502.h"
+#include "host_trace.h"
+
+// file layout : magic, little endian entry count, then the entries oldest first
+static const char traceMagic[8] = { 'N', 'E', 'S', 'T', 'R', 'A', 'C', 'E' };
+
+bool HostTraceDump(const char* fileName) {
+#if CPU_TRACE_RING
+	FILE* fp = fopen(fileName, "wb");
+	if (!fp)
+		return false;
+
+	const unsigned int numEntries = cpuTraceCount < CPU_TRACE_ENTRIES ? cpuTraceCount : CPU_TRACE_ENTRIES;
+	const unsigned int first = (cpuTraceCount - numEntries) & (CPU_TRACE_ENTRIES - 1);
+	fwrite(traceMagic, 1, sizeof(traceMagic), fp);
+	fwrite(&numEntries, sizeof(numEntries), 1, fp);
+
+	// the ring wraps at most once
+	const unsigned int untilEnd = CPU_TRACE_ENTRIES - first;
+	fwrite(&cpuTraceRing[first], sizeof(cpu_trace_entry), numEntries < untilEnd ? numEntries : untilEnd, fp);
+	if (numEntries > untilEnd) {
+		fwrite(&cpuTraceRing[0], sizeof(cpu_trace_entry), numEntries - untilEnd, fp);
+	}
+
+	const bool bSuccess = ferror(fp) == 0;
+	fclose(fp);
+	return bSuccess;
+#else
+	return false;
+#endif
+}
+
+#if CPU_TRACE_RING
+// FCEUX style line for one entry, matching cpu_instr_history::output
+static int FormatTraceEntry(const cpu_trace_entry& entry, bool bShowClocks, char* output) {
+	int len = 0;
+	if (bShowClocks) {
+		len += sprintf(output + len, "c%-11u ", entry.clocks);
+	}
+
+	len += sprintf(output + len, "A:%02X X:%02X Y:%02X S:%02X P:%s%s%s%s%s%s%s%s ",
+		entry.A,
+		entry.X,
+		entry.Y,
+		entry.SP,
+		entry.P & ST_NEG ? "N" : "n",
+		entry.P & ST_OVR ? "V" : "v",
+		entry.P & ST_UNUSED ? "U" : "u",
+		entry.P & ST_BRK ? "B" : "b",
+		entry.P & ST_BCD ? "D" : "d",
+		entry.P & ST_INT ? "I" : "i",
+		entry.P & ST_ZRO ? "Z" : "z",
+		entry.P & ST_CRY ? "C" : "c");
+
+	const unsigned int PC = entry.PC;
+	const unsigned int data1 = entry.data1;
+	const unsigned int data2 = entry.data2;
+	switch (entry.opcode) {
+#define OPCODE_0W(op,str,clk,sz,page,name,spc) case op: len += sprintf(output + len, "$%04X:%02X        " str, PC, op); break;
+#define OPCODE_1W(op,str,clk,sz,page,name,spc) case op: len += sprintf(output + len, "$%04X:%02X %02X     " str, PC, op, data1, data1); break;
+#define OPCODE_2W(op,str,clk,sz,page,name,spc) case op: len += sprintf(output + len, "$%04X:%02X %02X %02X  " str, PC, op, data1, data2, data1 + (data2 << 8)); break;
+#define OPCODE_REL(op,str,clk,sz,page,name,spc) case op: len += sprintf(output + len, "$%04X:%02X %02X     " str, PC, op, data1, (PC + 2 + ((signed char) data1)) & 0xFFFF); break;
+#include "6502_opcodes.inl"
+		default:
+			len += sprintf(output + len, "$%04X:%02X        ???", PC, entry.opcode);
+			break;
+	}
+
+	output[len++] = '\n';
+	output[len] = 0;
+	return len;
+}
+#endif
+
+bool HostTraceExport(const char* binaryFile, const char* textFile, bool bShowClocks) {
+#if CPU_TRACE_RING
+	FILE* in = fopen(binaryFile, "rb");
+	if (!in)
+		return false;
+
+	char magic[8];
+	unsigned int numEntries = 0;
+	if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) || memcmp(magic, traceMagic, sizeof(magic)) ||
+		fread(&numEntries, sizeof(numEntries), 1, in) != 1) {
+		fclose(in);
+		return false;
+	}
+
+	FILE* out = fopen(textFile, "w");
+	if (!out) {
+		fclose(in);
+		return false;
+	}
+
+	cpu_trace_entry entries[1024];
+	char line[256];
+	for (unsigned int remaining = numEntries; remaining;) {
+		const unsigned int numRead = fread(entries, sizeof(cpu_trace_entry), remaining < 1024 ? remaining : 1024, in);
+		if (numRead == 0)
+			break;
+
+		for (unsigned int i = 0; i < numRead; i++) {
+			fwrite(line, 1, FormatTraceEntry(entries[i], bShowClocks, line), out);
+		}
+		remaining -= numRead;
+	}
+
+	const bool bSuccess = ferror(in) == 0 && ferror(out) == 0;
+	fclose(in);
+	fclose(out);
+	return bSuccess;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+// dump and conversion of the binary instruction trace ring (CPU_TRACE_RING, see 6502.h)
+
+// writes the trace ring, oldest entry first, to the given file. Returns false if the ring is not enabled in this build
+// or the file could not be written
+bool HostTraceDump(const char* fileName);
+
+// converts a dumped binary trace to text in the FCEUX trace logger format (registers first, as
+// cpu_instr_history::output), optionally with the clock of each instruction. Effective address annotations are not
+// recorded, so those should be turned off (or stripped) in the reference log before comparing
+bool HostTraceExport(const char* binaryFile, const char* textFile, bool bShowClocks);
@@ -0,0 +1,38 @@
+#pragma once
+
+// Host stand-in for the scope_timer utility library. Accumulates inclusive wall clock time per named scope
+// so the host benchmark can report where each frame goes. Timers link themselves into a list on first use.
+
+struct ScopeTimer {
+	const char* name;
+	unsigned long long totalNanoseconds;
+	unsigned int count;
+	ScopeTimer* next;
+
+	ScopeTimer(const char* withName, int withLine);
+
+	void Register(const char* withName);
+
+	static unsigned long long GetNanoseconds();
+
+	static void InitSystem();
+	static void ReportFrame();
+	static void DisplayTimes();
+	static void Shutdown();
+
+	static ScopeTimer* firstTimer;
+};
+
+struct TimedInstance {
+	ScopeTimer* timer;
+	unsigned long long start;
+
+	TimedInstance(ScopeTimer* withTimer) : timer(withTimer), start(ScopeTimer::GetNanoseconds()) {}
+	~TimedInstance() {
+		timer->totalNanoseconds += ScopeTimer::GetNanoseconds() - start;
+		timer->count++;
+	}
+};
+
+#define TIME_SCOPE() static ScopeTimer __timer(__FUNCTION__, __LINE__); TimedInstance __timeMe(&__timer);
+#define TIME_SCOPE_NAMED(Name) static ScopeTimer __timer(#Name, __LINE__); TimedInstance __timeMe(&__timer);
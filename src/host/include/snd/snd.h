@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for the snd utility library. There is no audio device, the host benchmark
+// pulls sound buffers itself through sndFrame once per emulated frame.
+
+#define SOUND_RATE 44100
+
+// implemented by the emulator, fills the buffer with the given number of mixed samples
+extern void sndFrame(int* buffer, int length);
+
+inline void sndInit() {}
+inline void sndCleanup() {}
+inline void sndVolumeUp() {}
+inline void sndVolumeDown() {}
+inline void condSoundUpdate() {}
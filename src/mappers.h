@@ -8,7 +8,7 @@
 #include "scope_timer/scope_timer.h"
 
 FORCE_INLINE void memcpy_fast32(void* dest, const void* src, unsigned int size) {
-#if TARGET_WINSIM
+#if TARGET_WINSIM || TARGET_HOST
 	DebugAssert((((uint32)dest) & 3) == 0);
 	DebugAssert((((uint32)src) & 3) == 0);
 	DebugAssert((((uint32)size) & 31) == 0);
@@ -130,8 +130,8 @@ inline void mapPPU(unsigned int startAddrHigh, unsigned int numKB, unsigned char
 // register 13 is the IRQ latch (when set, IRQ is dispatched with each A12 jump)
 #define MMC3_IRQ_LATCH nesCart.registers[13]
 
-// registers 16-19 contain an integer of the last time the IRQ counter was reset, used to fix IRQ timing since we are cheating by performing logic at beginning ot scanline
-#define MMC3_IRQ_LASTSET *((unsigned int*) &nesCart.registers[16])
+// clock register 0 contains the last time the IRQ counter was reset, used to fix IRQ timing since we are cheating by performing logic at beginning ot scanline
+#define MMC3_IRQ_LASTSET nesCart.clockRegisters[0]
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // AOROM (switches nametables for single screen mirroring)
@@ -197,7 +197,7 @@ inline void mapPPU(unsigned int startAddrHigh, unsigned int numKB, unsigned char
 #define Mapper64_IRQ_MODE nesCart.registers[13]
 #define Mapper64_IRQ_ENABLE nesCart.registers[14]
 #define Mapper64_IRQ_COUNT nesCart.registers[15]
-#define Mapper64_IRQ_CLOCKS nesCart.registers[16]
+#define Mapper64_IRQ_CLOCKS nesCart.clockRegisters[0]
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Sunsoft 3 Mapper 67
@@ -208,7 +208,7 @@ inline void mapPPU(unsigned int startAddrHigh, unsigned int numKB, unsigned char
 #define Mapper67_CHR3 nesCart.registers[3]
 
 #define Mapper67_IRQ_WriteToggle nesCart.registers[4]
-#define Mapper67_IRQ_LastSet nesCart.registers[5]
+#define Mapper67_IRQ_LastSet nesCart.clockRegisters[0]
 #define Mapper67_IRQ_Counter nesCart.registers[6]
 #define Mapper67_IRQ_Enable nesCart.registers[7]
 
@@ -254,13 +254,13 @@ inline void mapPPU(unsigned int startAddrHigh, unsigned int numKB, unsigned char
 #define Mapper69_PARAM nesCart.registers[17]
 
 // next IRQ in cpu clocks
-#define Mapper69_IRQ nesCart.registers[18]
+#define Mapper69_IRQ nesCart.clockRegisters[1]
 
 // counter value at last set
 #define Mapper69_LASTCOUNTER nesCart.registers[19]
 
 // last clks used for counter value
-#define Mapper69_LASTCOUNTERCLK nesCart.registers[20]
+#define Mapper69_LASTCOUNTERCLK nesCart.clockRegisters[0]
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Mapper79 (American Video Entertainment)
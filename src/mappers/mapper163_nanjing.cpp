@@ -51,9 +51,11 @@ void nes_cart::Mapper163_ScanlineClock() {
 	if (Mapper163_REG[1] & 0x80) {
 		const int chrPage = nesCart.cachedBankCount + 1;
 		if (nesPPU.scanline == 240) {
+			nesPPU.catchUp();
 			nesPPU.chrPages[0] = nesCart.cache[chrPage].ptr;
 			nesPPU.chrPages[1] = nesCart.cache[chrPage].ptr;
 		} else if (nesPPU.scanline == 128) {
+			nesPPU.catchUp();
 			nesPPU.chrPages[0] = nesCart.cache[chrPage].ptr + 0x1000;
 			nesPPU.chrPages[1] = nesCart.cache[chrPage].ptr + 0x1000;
 		}
@@ -75,6 +77,7 @@ void nes_cart::Mapper163_Update() {
 	// not using the chr flip mode
 	if ((Mapper163_REG[1] & 0x80) == 0) {
 		const int chrPage = cachedBankCount + 1;
+		nesPPU.catchUp();
 		nesPPU.chrPages[0] = cache[chrPage].ptr;
 		nesPPU.chrPages[1] = cache[chrPage].ptr + 0x1000;
 	}
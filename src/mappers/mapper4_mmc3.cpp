@@ -67,7 +67,7 @@ void MMC3_writeSpecial(unsigned int address, unsigned char value) {
 				// IRQ counter reload value
 				MMC3_IRQ_SET = value;
 
-				if (MMC3_IRQ_LASTSET + (nesCart.isPAL ? 85 : 90) > mainCPU.clocks) {
+				if (CLOCKS_BEFORE(mainCPU.clocks, MMC3_IRQ_LASTSET + (nesCart.isPAL ? 85 : 90))) {
 					MMC3_IRQ_COUNTER = value;
 				}
 			} else {
@@ -185,7 +185,7 @@ void nes_cart::MMC3_ScanlineClock() {
 	const int OAM_LOOKUP_CYCLE = 82; // 82 is derived from: PPU clock 260 / 3 - half the largest instruction size, appears to get us compatible
 
 	if (nesPPU.PPUCTRL & PPUCTRL_SPRSIZE) {
-		// we need to build the fetch mask potentially
+		// we need to build the scanline sprite lists potentially
 		if (nesPPU.dirtyOAM) {
 			nesPPU.resolveOAMExternal();
 		}
@@ -193,35 +193,30 @@ void nes_cart::MMC3_ScanlineClock() {
 		// 8x16 sprites are a special case
 		flipCycles = OAM_LOOKUP_CYCLE;
 
-		// check which sprites are on this scanline to determine irq decrement amount
+		// check which sprites are on this scanline to determine irq decrement amount (walking OAM from sprite 63 down)
 		irqDec = 0;
-		unsigned char* curObj = &nesPPU.oam[252];
 		int lastPatternTable = 0;
-		int numSprites = 0;
-		int scanlineOffset = nesPPU.scanline - 2;
-
-		extern uint8 fetchMask[272];
-		for (int b = fetchMask[nesPPU.scanline]; b; b = b >> 1) {
-			if (!(b & 1)) {
-				curObj -= 32;
-				continue;
-			}
-
-			for (int i = 0; i < 8; i++, curObj -= 4) {
-				unsigned int yCoord = scanlineOffset - curObj[0];
+		const uint8* lineSprites = spriteLines[nesPPU.scanline];
+		int numSprites = spriteLineCount[nesPPU.scanline];
+		uint8 lastSprites[8];
+		if (spriteLineOverflow[nesPPU.scanline]) {
+			// the list only holds the first 8 sprites in OAM order, find the last 8 instead
+			const int scanlineOffset = nesPPU.scanline - 2;
+			numSprites = 0;
+			for (int sprite = 252; sprite >= 0 && numSprites < 8; sprite -= 4) {
+				unsigned int yCoord = scanlineOffset - nesPPU.oam[sprite];
 				if (yCoord < 16) {
-					numSprites++;
-					int patternTable = (curObj[1] & 1);
-					if (patternTable > lastPatternTable) {
-						irqDec++;
-					}
-					lastPatternTable = patternTable;
-
-					if (numSprites == 8) {
-						break;
-					}
+					lastSprites[7 - numSprites++] = sprite;
 				}
 			}
+			lineSprites = lastSprites;
+		}
+		for (int i = numSprites - 1; i >= 0; i--) {
+			int patternTable = (nesPPU.oam[lineSprites[i] + 1] & 1);
+			if (patternTable > lastPatternTable) {
+				irqDec++;
+			}
+			lastPatternTable = patternTable;
 		}
 		if (numSprites < 8 && lastPatternTable == 0) {
 			irqDec++;
@@ -251,7 +246,7 @@ void nes_cart::MMC3_ScanlineClock() {
 				}
 
 				MMC3_IRQ_RELOAD = 0;
-				MMC3_IRQ_LASTSET = mainCPU.ppuClocks - (341 / 3); // beginning of the scanline
+				MMC3_IRQ_LASTSET = mainCPU.eventClocks[EVENT_PPU] - (341 / 3); // beginning of the scanline
 			} else {
 				MMC3_IRQ_COUNTER--;
 
@@ -262,7 +257,7 @@ void nes_cart::MMC3_ScanlineClock() {
 
 			if (MMC3_IRQ_LATCH) {
 				// trigger an IRQ
-				mainCPU.setIRQ(0, mainCPU.ppuClocks - (341 / 3) + flipCycles);
+				mainCPU.setIRQ(0, mainCPU.eventClocks[EVENT_PPU] - (341 / 3) + flipCycles);
 			}
 		}
 	}
@@ -112,12 +112,12 @@ void Mapper64_writeSpecial(unsigned int address, unsigned char value) {
 			if (address & 1) {
 				// irq enable
 				Mapper64_IRQ_ENABLE = 1;
-				if (mainCPU.clocks < Mapper64_IRQ_CLOCKS) {
+				if (CLOCKS_BEFORE(mainCPU.clocks, Mapper64_IRQ_CLOCKS)) {
 					mainCPU.setIRQ(0, Mapper64_IRQ_CLOCKS);
 				}
 			} else {
 				// irq disable
-				if (mainCPU.clocks > Mapper64_IRQ_CLOCKS && Mapper64_IRQ_CLOCKS != 0) {
+				if (CLOCKS_BEFORE(Mapper64_IRQ_CLOCKS, mainCPU.clocks) && Mapper64_IRQ_CLOCKS != 0) {
 					Mapper64_IRQ_ENABLE = 1;
 					cpu6502_IRQ(0);
 					mainCPU.ackIRQ(0);
@@ -166,7 +166,7 @@ void nes_cart::Mapper64_ScanlineClock() {
 	const int OAM_LOOKUP_CYCLE = 82; // 82 is derived from: PPU clock 260 / 3 - half the largest instruction size, appears to get us compatible
 
 	if (nesPPU.PPUCTRL & PPUCTRL_SPRSIZE) {
-		// we need to build the fetch mask potentially
+		// we need to build the scanline sprite lists potentially
 		if (nesPPU.dirtyOAM) {
 			nesPPU.resolveOAMExternal();
 		}
@@ -174,35 +174,30 @@ void nes_cart::Mapper64_ScanlineClock() {
 		// 8x16 sprites are a special case
 		flipCycles = OAM_LOOKUP_CYCLE;
 
-		// check which sprites are on this scanline to determine irq decrement amount
+		// check which sprites are on this scanline to determine irq decrement amount (walking OAM from sprite 63 down)
 		irqDec = 0;
-		unsigned char* curObj = &nesPPU.oam[252];
 		int lastPatternTable = 0;
-		int numSprites = 0;
-		int scanlineOffset = nesPPU.scanline - 2;
-
-		extern uint8 fetchMask[272];
-		for (int b = fetchMask[nesPPU.scanline]; b; b = b >> 1) {
-			if (!(b & 1)) {
-				curObj -= 32;
-				continue;
-			}
-
-			for (int i = 0; i < 8; i++, curObj -= 4) {
-				unsigned int yCoord = scanlineOffset - curObj[0];
+		const uint8* lineSprites = spriteLines[nesPPU.scanline];
+		int numSprites = spriteLineCount[nesPPU.scanline];
+		uint8 lastSprites[8];
+		if (spriteLineOverflow[nesPPU.scanline]) {
+			// the list only holds the first 8 sprites in OAM order, find the last 8 instead
+			const int scanlineOffset = nesPPU.scanline - 2;
+			numSprites = 0;
+			for (int sprite = 252; sprite >= 0 && numSprites < 8; sprite -= 4) {
+				unsigned int yCoord = scanlineOffset - nesPPU.oam[sprite];
 				if (yCoord < 16) {
-					numSprites++;
-					int patternTable = (curObj[1] & 1);
-					if (patternTable > lastPatternTable) {
-						irqDec++;
-					}
-					lastPatternTable = patternTable;
-
-					if (numSprites == 8) {
-						break;
-					}
+					lastSprites[7 - numSprites++] = sprite;
 				}
 			}
+			lineSprites = lastSprites;
+		}
+		for (int i = numSprites - 1; i >= 0; i--) {
+			int patternTable = (nesPPU.oam[lineSprites[i] + 1] & 1);
+			if (patternTable > lastPatternTable) {
+				irqDec++;
+			}
+			lastPatternTable = patternTable;
 		}
 		if (numSprites < 8 && lastPatternTable == 0) {
 			irqDec++;
@@ -229,7 +224,7 @@ void nes_cart::Mapper64_ScanlineClock() {
 				Mapper64_IRQ_COUNT--;
 
 				if (Mapper64_IRQ_COUNT == 0) {
-					uint32 TargetClocks = mainCPU.ppuClocks - (341 / 3) + flipCycles;
+					cpu_clock TargetClocks = mainCPU.eventClocks[EVENT_PPU] - (341 / 3) + flipCycles;
 					if (Mapper64_IRQ_ENABLE) {
 						// trigger an IRQ
 						mainCPU.setIRQ(0, TargetClocks);
@@ -18,7 +18,7 @@ void nes_cart::Mapper67_Update() {
 	// set irq to latest if enabled
 	if (Mapper67_IRQ_Enable) {
 		mainCPU.setIRQ(0, Mapper67_IRQ_LastSet + Mapper67_IRQ_Counter);
-	} else if (mainCPU.clocks < mainCPU.irqClock[0]) {
+	} else if (CLOCKS_BEFORE(mainCPU.clocks, mainCPU.eventClocks[EVENT_IRQ0])) {
 		// disable future IRQ if applicable
 		mainCPU.ackIRQ(0);
 	}
@@ -55,7 +55,7 @@ void Mapper67_writeSpecial(unsigned int address, unsigned char value) {
 
 				// update counter by offset if applicable
 				if (Mapper67_IRQ_Enable) {
-					unsigned int clocksPassed = mainCPU.clocks - Mapper67_IRQ_LastSet;
+					unsigned int clocksPassed = (unsigned int) (mainCPU.clocks - Mapper67_IRQ_LastSet);
 					if (clocksPassed < Mapper67_IRQ_Counter) {
 						Mapper67_IRQ_Counter -= clocksPassed;
 					} else {
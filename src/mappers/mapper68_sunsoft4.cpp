@@ -19,8 +19,10 @@ void nes_cart::Mapper68_Update(bool bMapNametables) {
 		// map a cached bank for nametable ROM into nametable memory
 		unsigned char* table0 = cacheSingleCHRBank(Mapper68_NT0 / 8) + 1024 * (Mapper68_NT0 & 7);
 		unsigned char* table1 = cacheSingleCHRBank(Mapper68_NT1 / 8) + 1024 * (Mapper68_NT1 & 7);
+		nesPPU.catchUp();
 		memcpy_fast32(nesPPU.nameTables, table0, 1024);
 		memcpy_fast32(nesPPU.nameTables+1, table1, 1024);
+		nesPPU.invalidateRenderedMemory();
 	}
 }
 
@@ -66,7 +68,9 @@ void Mapper68_writeSpecial(unsigned int address, unsigned char value) {
 						bMapNametables = true;
 					} else {
 						// returning nametables to RAM, uncache from our area
+						nesPPU.catchUp();
 						memcpy_fast32(nesPPU.nameTables, cacheArea, 2048);
+						nesPPU.invalidateRenderedMemory();
 					}
 				}
 				switch (value & 3) {
@@ -68,14 +68,14 @@ void nes_cart::Mapper69_RunCommand(bool bIsForceUpdate) {
 	if (Mapper69_COMMAND == 0xD || bIsForceUpdate) {
 		Mapper69_IRQCONTROL = Mapper69_IRQCONTROL & 0x81;
 
-		if (Mapper69_IRQ > 0 && Mapper69_IRQ < mainCPU.clocks) {
+		if (Mapper69_IRQ != 0 && CLOCKS_BEFORE(Mapper69_IRQ, mainCPU.clocks)) {
 			Mapper69_IRQ = 0;
 		}
 
-		unsigned int countClks = Mapper69_LASTCOUNTERCLK + Mapper69_LASTCOUNTER;
+		cpu_clock countClks = Mapper69_LASTCOUNTERCLK + Mapper69_LASTCOUNTER;
 		if (Mapper69_IRQCONTROL & 0x80) {
 			// keep the counter up to date
-			while (countClks < mainCPU.clocks) {
+			while (CLOCKS_BEFORE(countClks, mainCPU.clocks)) {
 				countClks += 0x10000;
 				Mapper69_LASTCOUNTERCLK += 0x10000;
 			}
@@ -94,7 +94,7 @@ void nes_cart::Mapper69_RunCommand(bool bIsForceUpdate) {
 	if (Mapper69_COMMAND > 0xD) {
 		unsigned int actualCounter;
 		if (Mapper69_IRQCONTROL & 0x80) {
-			actualCounter = (Mapper69_LASTCOUNTERCLK + Mapper69_LASTCOUNTER - mainCPU.clocks) & 0xFFFF;
+			actualCounter = (unsigned int) (Mapper69_LASTCOUNTERCLK + Mapper69_LASTCOUNTER - mainCPU.clocks) & 0xFFFF;
 		} else {
 			actualCounter = Mapper69_LASTCOUNTER;
 		}
@@ -46,6 +46,48 @@ extern "C" {
 #define MAX_CACHED_ROM_BANKS 32
 #define STATIC_CACHED_ROM_BANKS 24
 
+// number of 8 KB PRG banks that can have a decoded instruction table at once (32 KB each, heap allocated while in game
+// if available, and freed for the menus)
+#define MAX_DECODED_PRG_BANKS 6
+
+// heap left free when allocating decoded instruction tables
+#define DECODED_HEAP_RESERVE (16 * 1024)
+
+// clocks value of a decoded op that has not been decoded yet
+#define DECODED_OP_EMPTY 0xFF
+
+// largest number of bytes a decoded op covers (fused sequences)
+#define MAX_DECODED_OP_SIZE 5
+
+// bytes per decoded CHR tile : 8 rows of 8 pixels, each the 2 bit color index pre-shifted for the palette OR
+#define DECODED_CHR_TILE_SIZE 64
+
+// number of 4 KB background pattern pages kept decoded at once (16 KB each, heap allocated while in game if available,
+// and freed for the menus)
+#define NUM_DECODED_CHR_PAGES 2
+
+// background rows cached for reuse while their inputs are unchanged, one per rendered scanline (~70 KB, heap allocated
+// while in game if available, and freed for the menus)
+#define NUM_BG_ROW_CACHE_LINES 240
+
+// interlaced fields alternate in bands of 4 lines, so the device sends each band with one LCD DMA (4 lines is a
+// multiple of the DMA's 32 byte transfer unit in every stretch mode)
+#define INTERLACE_BAND_SHIFT 2
+
+// scanlines may be rendered on a second thread (host only, see host/host_render_thread.h)
+#define PPU_RENDER_THREAD TARGET_HOST
+
+// resolved scanlines that can't affect emulation are deferred until a write that may change how they render, or the
+// end of the visible frame, then rendered together (WinSim / host only, the device's DMA is paced per scanline)
+#define PPU_CATCH_UP (TARGET_WINSIM || TARGET_HOST)
+
+// pre-decoded instruction, one per byte offset of a cached PRG bank so any entry point can be decoded
+struct nes_decoded_op {
+	uint8 opcode;		// instruction (or fused sequence) used for dispatch
+	uint8 clocks;		// base clock count of the instruction
+	uint16 operand;		// 1 or 2 operand bytes combined
+};
+
 struct nes_cached_bank {
 	unsigned char* ptr;
 	int32 request;
@@ -53,9 +95,13 @@ struct nes_cached_bank {
 	int32 prgIndex;
 	int16 chrIndex[8];
 
+	// index into nes_cart::decodedBanks if this PRG bank has a decoded op table, -1 otherwise
+	int32 decodedSlot;
+
 	void clear() {
 		request = -1;
 		prgIndex = -2;
+		decodedSlot = -1;
 	}
 };
 
@@ -82,6 +128,9 @@ struct nes_cart {
 	// up to 32 internal registers
 	unsigned int registers[32];
 
+	// master clock timestamps used by mapper IRQ timing
+	cpu_clock clockRegisters[2];
+
 	// bank index storage for program memory (which 8 KB from cart at 0x8000, 0xA000, 0xC000, amd 0xE000). Index 5 is for mappers that map to 0x6000 (only used if isLowPRGROM is true)
 	int32 programBanks[5];
 
@@ -154,8 +203,23 @@ struct nes_cart {
 	// finds least recently requested bank that is currently unused
 	int findOldestUnusedBank();
 
-	// caches an 8 KB PRG bank (so index up to 2 * numPRGBanks), returns result bank memory pointer
-	unsigned char* cachePRGBank(int index);
+	// caches an 8 KB PRG bank (so index up to 2 * numPRGBanks), returns result bank memory pointer. If decoded is given,
+	// it is set to the bank's decoded op table (filled lazily by the CPU as code executes), or null if none are available
+	unsigned char* cachePRGBank(int index, nes_decoded_op** decoded = nullptr);
+
+	// decoded op tables for up to MAX_DECODED_PRG_BANKS cached PRG banks, allocated in allocateDecodedBanks
+	nes_decoded_op* decodedBanks[MAX_DECODED_PRG_BANKS];
+	int numDecodedBanks;
+
+	// allocates decoded op tables from the heap (leaving DECODED_HEAP_RESERVE) and attaches them to the mapped banks,
+	// called when entering the game loop
+	void allocateDecodedBanks();
+
+	// frees the decoded op tables so the menus have the heap, called when leaving the game loop
+	void freeDecodedBanks();
+
+	// returns a decoded op table slot that isn't owned by a currently mapped bank (cleared to DECODED_OP_EMPTY), or -1 if none
+	int claimDecodedSlot();
 
 	// caches a 8 KB CHR bank based on the given 1 KB indices, returns result bank memory pointer
 	unsigned char* cacheCHRBank(int16* indices);
@@ -179,7 +243,6 @@ struct nes_cart {
 	bool setupMapper();
 
 	// rollback the clock counts in any mapper used registers by the given amt
-	void rollbackClocks(unsigned int clockCount);
 
 	// various mapper setups and functions
 	void setupMapper0_NROM();
@@ -287,6 +350,17 @@ namespace nes_mirror_type {
 	};
 }
 
+// state besides PPU memory that the rendered image depends on, compared between frames for static frame detection
+struct nes_render_state {
+	unsigned char* chrPages[2];
+	int scrollY;
+	int mirror;
+	unsigned char PPUCTRL;
+	unsigned char PPUMASK;
+	unsigned char SCROLLX;
+	bool flipY;
+};
+
 struct nes_ppu {
 	// registers (some of them map to $2000-$2007, but this is handled case by case)
 	unsigned char PPUCTRL;			// $2000
@@ -344,6 +418,109 @@ struct nes_ppu {
 	// pointer to function to render current scanline to scanline buffer (based on mirror mode)
 	void(*renderScanline)(nes_ppu& ppu);
 
+	// static frame detection : a frame where nothing rendered has changed since the last rendered frame is left on
+	// screen instead of being rendered
+	bool dirtyFrame;					// set by anything that may change the rendered image
+	bool staticFrame;					// current frame is unchanged so far
+	unsigned int staticFrames;			// total static frames
+	nes_render_state lastRenderState;	// state of the last rendered frame
+
+	// returns whether the frame starting now is static, and if it will be rendered begins tracking changes from it
+	bool checkStaticFrame(bool bSkipFrame);
+
+	// interlaced rendering : each frame renders only the scanlines of one field (even bands of lines from the first
+	// rendered line on even frames), leaving the other field from the last frame on screen
+	bool interlaceFrame;				// current frame is interlaced
+	bool interlaceFieldPending;			// the last changed frame's other field still needs rendering
+
+	// current scanline belongs to the field this frame leaves on screen
+	inline bool isOtherField() {
+		return interlaceFrame && ((((scanline - 9) >> INTERLACE_BAND_SHIFT) ^ frameCounter) & 1);
+	}
+
+	// nametable, OAM or palette memory changed
+	inline void dirtyMemory() {
+		dirtyFrame = true;
+#if PPU_RENDER_THREAD
+		renderMemoryVersion++;
+#endif
+	}
+
+	// pattern or nametable memory was replaced wholesale, invalidates anything rendered from it
+	inline void invalidateRenderedMemory() {
+		dirtyMemory();
+		bgRowCacheVersion++;
+	}
+
+	// version of each nametable row, incremented by writes to the row's tiles or attributes
+	uint16 nameTableRowVersion[4][30];
+
+	// version of all cached background rows, incremented when pattern memory changes contents or nametables are
+	// replaced wholesale
+	unsigned int bgRowCacheVersion;
+
+	// a write changed the nametable memory at dest, dirtying the nametable row(s) it belongs to
+	void dirtyNameTableRow(const unsigned char* dest);
+
+	// allocates the background row cache from the heap (leaving DECODED_HEAP_RESERVE), called when entering the game
+	// loop. Without it every row is rendered
+	void allocateBGRowCache();
+
+	// frees the background row cache so the menus have the heap, called when leaving the game loop
+	void freeBGRowCache();
+
+	// allocates the decoded background pattern pages from the heap (leaving DECODED_HEAP_RESERVE), called when entering
+	// the game loop. Without them the background renders straight from pattern memory
+	void allocateDecodedCHR();
+
+	// frees the decoded pattern pages so the menus have the heap, called when leaving the game loop
+	void freeDecodedCHR();
+
+	// pattern memory in the given range changed, its decoded tiles are decoded again when next rendered
+	void invalidateDecodedCHR(const unsigned char* memory, unsigned int size);
+
+#if PPU_RENDER_THREAD
+	// incremented with any change to the memory the render thread copies (nametables, OAM, working palette)
+	unsigned int renderMemoryVersion;
+
+	// waits for lines queued to the render thread before changing memory it reads directly (CHR memory, cached
+	// banks, the scanline sprite lists and the screen)
+	void syncRender();
+#else
+	inline void syncRender() {}
+#endif
+
+#if PPU_CATCH_UP
+	unsigned int catchUpFirst;			// first deferred scanline, 0 if none are pending
+	unsigned int catchUpLast;			// last deferred scanline
+	unsigned int catchUpSpans;			// total spans of deferred lines rendered
+	unsigned int catchUpLines;			// total deferred lines rendered
+
+	// renders the pending span of deferred scanlines with the current registers
+	void renderCatchUp();
+
+	// called before any write that may change how a deferred scanline renders (PPU registers, OAM, CHR banks, mirroring)
+	inline void catchUp() {
+		if (catchUpFirst) {
+			renderCatchUp();
+		}
+	}
+#else
+	inline void catchUp() {}
+#endif
+
+	// rendering the current scanline may set the sprite 0 hit or decrement the scroll, so emulation depends on it
+	inline bool lineAffectsEmulation() {
+		const unsigned int spriteSize = (PPUCTRL & PPUCTRL_SPRSIZE) ? 16 : 8;
+		return (canSprite0Hit() && scanline - oam[0] - 2 < spriteSize) || causeDecrement;
+	}
+
+	// renders and resolves the current scanline (on the render thread if active)
+	void renderResolvedLine();
+
+	// renders the current scanline without resolving it, for its sprite 0 hit or scroll decrement
+	void renderUnresolvedLine();
+
 	// oam data
 	unsigned char oam[0x100];
 	bool dirtyOAM;
@@ -354,15 +531,24 @@ struct nes_ppu {
 
 	void setMirrorType(int withType);
 
+	// points renderScanline at the renderer for the current mirroring, MMC2/4 render latch and sprite size
+	void selectRenderScanline();
+
 	// current 565 color palette, set up with initPalette()
 	unsigned short rgbPalette[64];
 
+	// rgbPalette with each combination of emphasis bits applied (indexed by PPUMASK >> 5), set up with initPalette()
+	unsigned short emphasisPalettes[8][64];
+
 	// perform an OAM dma from the given CPU memory address
 	void oamDMA(unsigned int addr);
 	template<int spriteSize> void resolveOAM();
 	void resolveOAMExternal();
 	void fastOAMLatchCheck();
 
+	// sets the sprite overflow flag if the current scanline has more than 8 sprites (when rendering is enabled)
+	void checkSpriteOverflow();
+
 	// reading / writing
 	inline unsigned char* resolveMemoryAddress(unsigned int address, bool mirrorBehindPalette) {
 		address &= 0x3FFF;
@@ -421,6 +607,7 @@ struct nes_ppu {
 	// internal NMI handling
 	bool triggerNMI;
 	bool setVBL;
+	bool startedUp;			// past the first few frames after reset where VBL / NMI are not raised
 
 	// scroll handling
 	int scrollY;
@@ -434,10 +621,26 @@ struct nes_ppu {
 
 	// main rendering
 	void fastSprite0(bool bValidBackground);
-	void doOAMRender();
+	template<int spriteSize> void doOAMRender();
 	void resolveScanline(int scrollOffset);
 	void finishFrame(bool bSkippedFrame);
 
+	// hash of each line as last resolved to the screen, so unchanged lines can skip the resolve
+	uint32 resolvedLineHash[240][2];
+	uint32 resolvedLineScroll[240];		// scroll each line was last resolved with
+	uint32 workingPaletteHash;
+
+	unsigned int linesSkipped;				// unchanged lines skipped so far this frame
+	unsigned int lastFrameLinesSkipped;		// unchanged lines skipped by the last rendered frame
+	unsigned int totalLinesSkipped;
+
+	// updates the resolved hash of the current line, returns true if it matches what is on screen (not used by the
+	// stretched modes, which interlace lines differently each frame)
+	bool lineUnchanged(int scrollOffset);
+
+	// forces every line to resolve and render on the next frame (when the screen has been drawn over)
+	void invalidateResolvedLines();
+
 	// renders background color overscan area for game background color option
 	void renderBGOverscan();
 
@@ -451,15 +654,16 @@ struct nes_ppu {
 	bool canSprite0Hit() {
 		return (PPUSTATUS & PPUSTAT_SPRITE0) == 0 && (PPUMASK & (PPUMASK_SHOWOBJ | PPUMASK_SHOWBG));
 	}
-
-	static void renderScanline_SingleMirror(nes_ppu& ppu);
-	static void renderScanline_HorzMirror(nes_ppu& ppu);
-	static void renderScanline_VertMirror(nes_ppu& ppu);
-	static void renderScanline_4PaneMirror(nes_ppu& ppu);
 };
 
 extern nes_ppu nesPPU;
 
+// sprites on each scanline as OAM byte offsets in OAM order (at most 8, the rest set the overflow), built by resolveOAM
+#define SPRITE_LINES 241
+extern uint8 spriteLines[SPRITE_LINES][8];
+extern uint8 spriteLineCount[SPRITE_LINES];
+extern uint8 spriteLineOverflow[SPRITE_LINES];
+
 extern const uint8 OverlayTable[8 * 256];
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -471,7 +675,10 @@ struct nes_apu_pulse {
 	void step_quarter();
 	void step_half();
 
-	int mixOffset;
+	// mix state : sequencer step, sample time of the next step (16.16) and last output level
+	int mixStep;
+	unsigned int mixTime;
+	int mixLevel;
 
 	int rawPeriod;
 	int lengthCounter;
@@ -502,7 +709,10 @@ struct nes_apu_triangle {
 	void step_quarter();
 	void step_half();
 
-	int mixOffset;
+	// mix state : sequencer step, sample time of the next step (16.16) and last output level
+	int mixStep;
+	unsigned int mixTime;
+	int mixLevel;
 
 	int rawPeriod;
 	int lengthCounter;
@@ -521,8 +731,11 @@ struct nes_apu_noise {
 
 	int shiftRegister;
 
-	int clocks;
-	int samplesPerPeriod;
+	// mix state : sample time of the next shift (16.16) and last output level
+	unsigned int mixTime;
+	int mixLevel;
+
+	int period;						// in CPU clocks
 	int noiseMode;
 
 	int lengthCounter;
@@ -546,15 +759,18 @@ struct nes_apu_dmc {
 
 	// current state
 	int output;
-	int clocks;
 	int sampleBuffer;
 	int bitCount;
 	bool silentFlag;
 	unsigned int curSampleAddress;
 	unsigned int remainingLength;
 
+	// mix state : sample time of the next output bit (16.16) and last output level
+	unsigned int mixTime;
+	int mixLevel;
+
 	// sample data
-	int samplesPerPeriod;
+	int period;						// in CPU clocks per output bit
 	unsigned int sampleAddress;
 	int length;
 
@@ -563,17 +779,58 @@ struct nes_apu_dmc {
 	bool loop;
 };
 
+// pulse, triangle and noise generators
+struct nes_apu_generators {
+	nes_apu_pulse pulse1;
+	nes_apu_pulse pulse2;
+	nes_apu_triangle triangle;
+	nes_apu_noise noise;
+
+	// channel enable flags from $4015 (length counters of disabled channels can't be loaded)
+	uint8 enabled;
+
+	void init();
+
+	// write to generator registers ($4000-$400F) or the channel flags ($4015)
+	void writeReg(unsigned int address, uint8 value);
+
+	void step_quarter();
+	void step_half();
+};
+
+// pseudo registers of the frame counter steps in the APU event queue
+#define APU_EVENT_QUARTER 0x18
+#define APU_EVENT_HALF 0x19
+
+#define APU_EVENT_QUEUE_SIZE 256
+
+// a register write or frame counter step at the given CPU clock, queued for the mix
+struct nes_apu_event {
+	cpu_clock clocks;
+	uint8 address;
+	uint8 value;
+};
+
 // audio processing unit main struct
 struct nes_apu {
 	nes_apu() {
 		init();
 	}
 
-	nes_apu_pulse pulse1;
-	nes_apu_pulse pulse2;
-	nes_apu_triangle triangle;
-	nes_apu_noise noise;
+	// emulated generator state (for the length counter status)
+	nes_apu_generators channels;
+
+	// the mix's copy of the generators, brought up to date by replaying the queued events at their time in the mix, so
+	// changes within a mix (arpeggios, envelopes) are heard where they happen instead of all at the start of the next
+	nes_apu_generators mixChannels;
+
 	nes_apu_dmc dmc;
+
+	// queued events and the CPU clock the last mix ended at
+	nes_apu_event events[APU_EVENT_QUEUE_SIZE];
+	unsigned int eventsQueued;
+	unsigned int eventsMixed;
+	cpu_clock mixClocks;
 	
 	int cycle;
 	int mode;	// 0 = 4 step, 1 = 5 step
@@ -595,7 +852,7 @@ struct nes_apu {
 
 	void clearDMCIRQ();
 
-	// apu update step called every at 240 Hz by cpu (nes_cpu.apuClocks)
+	// apu update step called every at 240 Hz by cpu (EVENT_APU)
 	void step();
 
 	// step quarter frame counters of generators
@@ -608,6 +865,15 @@ struct nes_apu {
 
 	void shutdown();
 
+	// queues a register write or frame counter step for the mix (applied right away without sound)
+	void queueEvent(unsigned int address, uint8 value);
+
+	// applies a queued event to the mix's state
+	void applyEvent(const nes_apu_event& event);
+
+	// mixes samples up to the given CPU clock, replaying the events before it
+	void mixSamples(int* intoBuffer, int length, cpu_clock toClocks);
+
 };
 
 extern nes_apu nesAPU;
@@ -27,25 +27,20 @@ static bool bEnabled_dmc = true;
 const unsigned int palFrame = 8313;
 const unsigned int ntscFrame = 7457;
 
-// how much of a duty cycle sample from above to move through per sample, divided by 256
-int duty_delta(int t) {
+// sample rate of the mix (the Prizm sound library mixes at half of SOUND_RATE)
 #if TARGET_PRIZM
-	if (nesCart.isPAL) {
-		const int soundNumerator = int(8192.0f / SOUND_RATE * 1662607);
-		return soundNumerator / (t + 1);
-	} else {
-		const int soundNumerator = int(8192.0f / SOUND_RATE * 1789773);
-		return soundNumerator / (t + 1);
-	}
+#define MIX_RATE (SOUND_RATE / 2)
 #else
-	if (nesCart.isPAL) {
-		const int soundNumerator = int(4096.0f / SOUND_RATE * 1662607);
-		return soundNumerator / (t + 1);
-	} else {
-		const int soundNumerator = int(4096.0f / SOUND_RATE * 1789773);
-		return soundNumerator / (t + 1);
-	}
+#define MIX_RATE SOUND_RATE
 #endif
+
+// samples per CPU clock (8.24)
+static const unsigned int ntscClockTime = (unsigned int)(((unsigned long long) MIX_RATE << 24) / 1789773);
+static const unsigned int palClockTime = (unsigned int)(((unsigned long long) MIX_RATE << 24) / 1662607);
+
+// sample time (16.16) of the given number of CPU clocks (up to 4096)
+inline unsigned int mix_time(unsigned int clocks, unsigned int clockTime) {
+	return (clocks * clockTime) >> 8;
 }
 
 static uint8 length_counter_table[32] = {
@@ -56,11 +51,11 @@ static uint8 length_counter_table[32] = {
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // APU PULSE
 
-static const int pulse_duty[4][16] = {
-	{ 0, 1, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},   // 12.5% duty
-	{ 0, 1, 4, 4, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0},   // 25% duty
-	{ 0, 1, 4, 4, 4, 4, 4, 4, 4, 4, 1, 0, 0, 0, 0, 0},   // 50% duty
-	{ 4, 4, 1, 0, 0, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4}    // -25% duty
+static const int pulse_duty[4][8] = {
+	{ 0, 1, 0, 0, 0, 0, 0, 0 },		// 12.5% duty
+	{ 0, 1, 1, 0, 0, 0, 0, 0 },		// 25% duty
+	{ 0, 1, 1, 1, 1, 0, 0, 0 },		// 50% duty
+	{ 1, 0, 0, 1, 1, 1, 1, 1 }		// -25% duty
 };
 
 // calculates the target period of the sweep unit
@@ -190,20 +185,6 @@ void nes_apu_pulse::step_half() {
 	if (enableLengthCounter && lengthCounter) {
 		lengthCounter--;
 	}
-
-	if (sweepTwosComplement) {
-		if (lengthCounter) {
-			mainCPU.specialMemory[0x15] |= 0x02;
-		} else {
-			mainCPU.specialMemory[0x15] &= ~0x02;
-		}
-	} else {
-		if (lengthCounter) {
-			mainCPU.specialMemory[0x15] |= 0x01;
-		} else {
-			mainCPU.specialMemory[0x15] &= ~0x01;
-		}
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -275,29 +256,11 @@ void nes_apu_triangle::step_half() {
 	if (enableLengthCounter && lengthCounter) {
 		lengthCounter--;
 	}
-
-	if (lengthCounter) {
-		mainCPU.specialMemory[0x15] |= 0x04;
-	} else {
-		mainCPU.specialMemory[0x15] &= ~0x04;
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // APU NOISE
 
-// number of samples between noise shift register switches (x16, clamped at 8)
-inline int noise_samples(int noisePeriod) {
-#if TARGET_PRIZM
-	int samples = noisePeriod * (SOUND_RATE) / 111861;
-#else
-	int samples = noisePeriod * (SOUND_RATE * 2) / 111861;
-#endif
-
-	if (samples < 8) return 8;
-	return samples;
-}
-
 static const int noise_period_ntsc[16] = {
 	4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
 };
@@ -346,7 +309,6 @@ void nes_apu_noise::writeReg(unsigned int regNum, uint8 value) {
 	regHelper helper;
 	helper.value = value;
 
-	int noisePeriod;
 	switch (regNum) {
 		case 0:
 			enableLengthCounter = helper.loop_or_halt == 0;
@@ -362,13 +324,9 @@ void nes_apu_noise::writeReg(unsigned int regNum, uint8 value) {
 			break;
 		case 2:
 			if (nesCart.isPAL) {
-				noisePeriod = noise_period_pal[helper.noise_period];
+				period = noise_period_pal[helper.noise_period];
 			} else {
-				noisePeriod = noise_period_ntsc[helper.noise_period];
-			}
-			samplesPerPeriod = noise_samples(noisePeriod);
-			if (clocks > samplesPerPeriod) {
-				clocks = clocks & 0xF;
+				period = noise_period_ntsc[helper.noise_period];
 			}
 			noiseMode = helper.noise_mode;
 			break;
@@ -403,12 +361,6 @@ void nes_apu_noise::step_half() {
 	if (enableLengthCounter && lengthCounter) {
 		lengthCounter--;
 	}
-
-	if (lengthCounter) {
-		mainCPU.specialMemory[0x15] |= 0x08;
-	} else {
-		mainCPU.specialMemory[0x15] &= ~0x08;
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -451,7 +403,6 @@ void nes_apu_dmc::writeReg(unsigned int regNum, uint8 value) {
 	regHelper helper;
 	helper.value = value;
 
-	int dmcPeriod;
 	switch (regNum) {
 		case 0:
 			if (helper.irq) {
@@ -464,11 +415,10 @@ void nes_apu_dmc::writeReg(unsigned int regNum, uint8 value) {
 			loop = helper.loop != 0;
 
 			if (nesCart.isPAL) {
-				dmcPeriod = dmc_pitch_ntsc[helper.frequency];
+				period = dmc_pitch_ntsc[helper.frequency];
 			} else {
-				dmcPeriod = dmc_pitch_pal[helper.frequency];
+				period = dmc_pitch_pal[helper.frequency];
 			}
-			samplesPerPeriod = noise_samples(dmcPeriod);
 			break;
 		case 1:
 			output = helper.level_load;
@@ -512,7 +462,7 @@ void nes_apu_dmc::step() {
 				}
 				if (irqEnabled) {
 					mainCPU.specialMemory[0x15] |= 0x80;
-					mainCPU.setIRQ(2, 0); 
+					mainCPU.setIRQ(2, mainCPU.clocks); 
 				}
 			}
 
@@ -550,37 +500,115 @@ void sndFrame(int* buffer, int length) {
 	nesAPU.mix(buffer, length);
 }
 
-void nes_apu::init() {
-	memset(this, 0, sizeof(nes_apu));
+static void blip_clear();
+
+void nes_apu_generators::init() {
 	pulse2.sweepTwosComplement = true;
 	noise.shiftRegister = 1;
-	mainCPU.specialMemory[0x15] = 0;
 }
 
-void nes_apu::startup() {
-	bSoundEnabled = nesSettings.GetSetting(ST_SoundEnabled) != 0;
-	if (bSoundEnabled) {
-		sndInit();
-	}
-}
-
-void nes_apu::writeReg(unsigned int address, uint8 value) {
+void nes_apu_generators::writeReg(unsigned int address, uint8 value) {
 	if (address < 0x04) {
 		pulse1.writeReg(address, value);
+		if ((enabled & 1) == 0) pulse1.lengthCounter = 0;
 	} else if (address < 0x08) {
 		pulse2.writeReg(address & 0x3, value);
+		if ((enabled & 2) == 0) pulse2.lengthCounter = 0;
 	} else if (address < 0x0C) {
 		triangle.writeReg(address & 0x3, value);
+		if ((enabled & 4) == 0) triangle.lengthCounter = 0;
 	} else if (address < 0x10) {
 		noise.writeReg(address & 0x3, value);
-	} else if (address < 0x14) {
-		dmc.writeReg(address & 0x3, value);
+		if ((enabled & 8) == 0) noise.lengthCounter = 0;
 	} else if (address == 0x15) {
 		// channel flags : DNT21
+		enabled = value;
 		if ((value & 1) == 0) pulse1.lengthCounter = 0;
 		if ((value & 2) == 0) pulse2.lengthCounter = 0;
 		if ((value & 4) == 0) triangle.lengthCounter = 0;
 		if ((value & 8) == 0) noise.lengthCounter = 0;
+	}
+}
+
+void nes_apu_generators::step_quarter() {
+	pulse1.step_quarter();
+	pulse2.step_quarter();
+	triangle.step_quarter();
+	noise.step_quarter();
+}
+
+void nes_apu_generators::step_half() {
+	pulse1.step_half();
+	pulse2.step_half();
+	triangle.step_half();
+	noise.step_half();
+}
+
+void nes_apu::init() {
+	memset(this, 0, sizeof(nes_apu));
+	blip_clear();
+	channels.init();
+	mixChannels.init();
+	mainCPU.specialMemory[0x15] = 0;
+}
+
+void nes_apu::startup() {
+	bSoundEnabled = nesSettings.GetSetting(ST_SoundEnabled) != 0;
+	if (bSoundEnabled) {
+		sndInit();
+	}
+
+	// catch the mix up with anything queued while it wasn't running
+	while (eventsMixed != eventsQueued) {
+		applyEvent(events[eventsMixed++ & (APU_EVENT_QUEUE_SIZE - 1)]);
+	}
+	mixClocks = mainCPU.clocks;
+}
+
+void nes_apu::queueEvent(unsigned int address, uint8 value) {
+	nes_apu_event event;
+	event.clocks = mainCPU.clocks;
+	event.address = address;
+	event.value = value;
+
+	// without sound there is no mix to replay events
+	if (!bSoundEnabled) {
+		applyEvent(event);
+		return;
+	}
+
+	// a full queue gives up the timing of the oldest event
+	if (eventsQueued - eventsMixed == APU_EVENT_QUEUE_SIZE) {
+		applyEvent(events[eventsMixed++ & (APU_EVENT_QUEUE_SIZE - 1)]);
+	}
+
+	events[eventsQueued++ & (APU_EVENT_QUEUE_SIZE - 1)] = event;
+}
+
+void nes_apu::applyEvent(const nes_apu_event& event) {
+	if (event.address == APU_EVENT_QUARTER) {
+		mixChannels.step_quarter();
+	} else if (event.address == APU_EVENT_HALF) {
+		mixChannels.step_half();
+	} else if (event.address == 0x11) {
+		dmc.writeReg(1, event.value);
+	} else {
+		mixChannels.writeReg(event.address, event.value);
+	}
+}
+
+void nes_apu::writeReg(unsigned int address, uint8 value) {
+	if (address < 0x10) {
+		channels.writeReg(address, value);
+		queueEvent(address, value);
+	} else if (address == 0x11) {
+		// direct load of the DMC output, only heard so it is applied in the mix
+		queueEvent(address, value);
+	} else if (address < 0x14) {
+		dmc.writeReg(address & 0x3, value);
+	} else if (address == 0x15) {
+		channels.writeReg(address, value);
+		queueEvent(address, value);
 
 		// dmc is special
 		if ((value & 16) == 0)
@@ -603,7 +631,7 @@ void nes_apu::writeReg(unsigned int address, uint8 value) {
 		}
 
 		// reset step counter
-		mainCPU.apuClocks = mainCPU.clocks + (nesCart.isPAL ? palFrame : ntscFrame);
+		mainCPU.schedule(EVENT_APU, mainCPU.clocks + (nesCart.isPAL ? palFrame : ntscFrame));
 		cycle = 0;
 	}
 }
@@ -634,18 +662,18 @@ void nes_apu::step() {
 		case 0:
 			step_quarter();
 			cycle = 1;
-			mainCPU.apuClocks += frameBase - 1;
+			mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase - 1);
 			break;
 		case 1:
 			step_quarter();
 			step_half();
 			cycle = 2;
-			mainCPU.apuClocks += frameBase + 1;
+			mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase + 1);
 			break;
 		case 2:
 			step_quarter();
 			cycle = 3;
-			mainCPU.apuClocks += frameBase + 2;
+			mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase + 2);
 			break;
 		case 3:
 			if (mode == 0) {
@@ -656,36 +684,40 @@ void nes_apu::step() {
 				// do an irq?
 				if (inhibitIRQ == false) {
 					mainCPU.specialMemory[0x15] |= 0x40;
-					mainCPU.setIRQ(1, 0);
+					mainCPU.setIRQ(1, mainCPU.clocks);
 				}
 
-				mainCPU.apuClocks += frameBase;
+				mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase);
 			} else {
 				cycle = 4;
-				mainCPU.apuClocks += frameBase - 5;
+				mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase - 5);
 			}
 			break;
 		case 4:
 			step_quarter();
 			step_half(); 
 			cycle = 0;
-			mainCPU.apuClocks += frameBase;
+			mainCPU.schedule(EVENT_APU, mainCPU.eventClocks[EVENT_APU] + frameBase);
 			break;
 	}
 }
 
 void nes_apu::step_quarter() {
-	pulse1.step_quarter();
-	pulse2.step_quarter();
-	triangle.step_quarter();
-	noise.step_quarter();
+	channels.step_quarter();
+	queueEvent(APU_EVENT_QUARTER, 0);
 }
 
 void nes_apu::step_half() {
-	pulse1.step_half();
-	pulse2.step_half();
-	triangle.step_half();
-	noise.step_half();
+	channels.step_half();
+	queueEvent(APU_EVENT_HALF, 0);
+
+	// length counter status : NT21
+	uint8 status = mainCPU.specialMemory[0x15] & ~0x0F;
+	if (channels.pulse1.lengthCounter) status |= 0x01;
+	if (channels.pulse2.lengthCounter) status |= 0x02;
+	if (channels.triangle.lengthCounter) status |= 0x04;
+	if (channels.noise.lengthCounter) status |= 0x08;
+	mainCPU.specialMemory[0x15] = status;
 }
 
 void nes_apu::shutdown() {
@@ -697,169 +729,296 @@ void nes_apu::shutdown() {
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // MIX
 
-void nes_apu::mix(int* intoBuffer, int length) {
-	TIME_SCOPE();
-
-	bool bHighQuality = nesSettings.GetSetting(ST_SoundQuality) != 0;
+// band limited synthesis : channels add the change in their output level at the (fractional) sample time it happens,
+// as a short band limited impulse, into a buffer of deltas that is integrated once per mix into the output samples.
+// So the work per sample is just the integration, plus a little per waveform edge
+#define BLIP_PHASE_BITS 5					// sub sample positions (bits)
+#define BLIP_TAPS 8							// impulse width in samples
+#define BLIP_BITS 14						// impulse fixed point bits (each phase sums to 1 << BLIP_BITS)
+#define BLIP_MAX_SAMPLES 1024				// most samples integrated at once
+
+// windowed sinc impulses (Hann window, cutoff at 0.9 of the mix Nyquist frequency) for each sub sample position
+static const int16 blip_impulse[1 << BLIP_PHASE_BITS][BLIP_TAPS] = {
+	{   206,  -767,  1376, 14754,  1376,  -767,   206,     0 },
+	{   179,  -644,   957, 14731,  1819,  -892,   234,     0 },
+	{   153,  -525,   562, 14667,  2284, -1018,   262,    -1 },
+	{   128,  -410,   193, 14560,  2769, -1145,   291,    -2 },
+	{   105,  -301,  -149, 14411,  3272, -1270,   319,    -3 },
+	{    84,  -197,  -464, 14220,  3792, -1393,   347,    -5 },
+	{    65,  -100,  -751, 13990,  4326, -1512,   373,    -7 },
+	{    47,   -10, -1010, 13721,  4873, -1625,   398,   -10 },
+	{    32,    73, -1242, 13415,  5429, -1731,   420,   -12 },
+	{    18,   148, -1445, 13075,  5992, -1829,   440,   -15 },
+	{     7,   215, -1621, 12703,  6559, -1917,   456,   -18 },
+	{    -3,   275, -1770, 12299,  7128, -1993,   468,   -20 },
+	{   -11,   326, -1893, 11866,  7697, -2055,   477,   -23 },
+	{   -17,   370, -1990, 11408,  8261, -2103,   480,   -25 },
+	{   -21,   405, -2063, 10926,  8819, -2134,   478,   -26 },
+	{   -24,   434, -2113, 10424,  9367, -2147,   469,   -26 },
+	{   -26,   455, -2140,  9903,  9903, -2140,   455,   -26 },
+	{   -26,   469, -2147,  9367, 10424, -2113,   434,   -24 },
+	{   -26,   478, -2134,  8819, 10926, -2063,   405,   -21 },
+	{   -25,   480, -2103,  8261, 11408, -1990,   370,   -17 },
+	{   -23,   477, -2055,  7697, 11866, -1893,   326,   -11 },
+	{   -20,   468, -1993,  7128, 12299, -1770,   275,    -3 },
+	{   -18,   456, -1917,  6559, 12703, -1621,   215,     7 },
+	{   -15,   440, -1829,  5992, 13075, -1445,   148,    18 },
+	{   -12,   420, -1731,  5429, 13415, -1242,    73,    32 },
+	{   -10,   398, -1625,  4873, 13721, -1010,   -10,    47 },
+	{    -7,   373, -1512,  4326, 13990,  -751,  -100,    65 },
+	{    -5,   347, -1393,  3792, 14220,  -464,  -197,    84 },
+	{    -3,   319, -1270,  3272, 14411,  -149,  -301,   105 },
+	{    -2,   291, -1145,  2769, 14560,   193,  -410,   128 },
+	{    -1,   262, -1018,  2284, 14667,   562,  -525,   153 },
+	{     0,   234,  -892,  1819, 14731,   957,  -644,   179 },
+};
 
-	int triVolume = 237;
-	CHECK_ENABLED(tri);
-	if (triangle.linearCounter == 0 || triangle.lengthCounter == 0 || triangle.rawPeriod < 2)
-		triVolume = 0;
+static int blip_deltas[BLIP_MAX_SAMPLES + BLIP_TAPS];
+static int blip_level = 0;					// integrated level, carried between mixes
 
-	if (triVolume) {
-		int delta = duty_delta(triangle.rawPeriod * 2);
+static void blip_clear() {
+	memset(blip_deltas, 0, sizeof(blip_deltas));
+	blip_level = 0;
+}
 
-		for (int32 i = 0; i < length; i++) {
-			triangle.mixOffset = (triangle.mixOffset + delta) & 0xFFFF;
-			intoBuffer[i] = tri_duty[(triangle.mixOffset >> 11)] * triVolume;
+// adds the change of a channel's output level at the given sample time (16.16), as a band limited impulse or as a plain
+// step at the nearest sample (for noise, and channels stepping more often than samples where impulses cost too much)
+template<bool bBandLimited>
+inline void blip_add_delta(unsigned int time, int delta) {
+	if (bBandLimited) {
+		const int16* impulse = blip_impulse[(time >> (16 - BLIP_PHASE_BITS)) & ((1 << BLIP_PHASE_BITS) - 1)];
+		int* deltas = &blip_deltas[time >> 16];
+		for (int i = 0; i < BLIP_TAPS; i++) {
+			deltas[i] += impulse[i] * delta;
 		}
 	} else {
-		for (int32 i = 0; i < length; i++) {
-			intoBuffer[i] = 0;
-		}
+		// aligned with the center of the impulses
+		blip_deltas[((time + 0x8000) >> 16) + BLIP_TAPS / 2 - 1] += delta << BLIP_BITS;
+	}
+}
 
-		triangle.mixOffset = (triangle.mixOffset + duty_delta(triangle.rawPeriod) * length) & 0xFFFF;
+// moves a channel's output to the given level at the given sample time (16.16)
+template<bool bBandLimited>
+inline void mix_level(int& mixLevel, unsigned int time, int level) {
+	if (level != mixLevel) {
+		blip_add_delta<bBandLimited>(time, level - mixLevel);
+		mixLevel = level;
 	}
+}
 
-	int noiseVolume = 138 * (noise.useConstantVolume ? noise.constantVolume : noise.envelopeVolume);
-	if (noise.lengthCounter == 0)
-		noiseVolume = 0;
+// a channel that holds its step until the given time (the last step time may be later already)
+inline void hold_step(unsigned int& mixTime, unsigned int time) {
+	if (mixTime < time) mixTime = time;
+}
 
-	CHECK_ENABLED(noise);
-	if (noiseVolume && noise.samplesPerPeriod) {
-		int remainingLength = length;
-		int* bufferWrite = intoBuffer;
-
-		while (remainingLength > 0) {
-			int curFeedback = noise.shiftRegister & 1;
-			if (noise.noiseMode)
-				curFeedback = curFeedback ^ ((noise.shiftRegister >> 6) & 1);
-			else
-				curFeedback = curFeedback ^ ((noise.shiftRegister >> 1) & 1);
-			int curFeedbackVolume = curFeedback ? noiseVolume : 0;
-
-			int toMixClocks = noise.samplesPerPeriod - noise.clocks;
-			int toMixSamples = toMixClocks >> 4;
-			if (remainingLength < toMixSamples) {
-				toMixSamples = remainingLength;
-				noise.clocks = (toMixSamples << 4);
-			} else {
-				noise.shiftRegister = (noise.shiftRegister >> 1) | (curFeedback << 14);
-				noise.clocks = (toMixSamples << 4) - toMixClocks;
-			}
+// each mixer runs its channel from startTime to endTime (16.16 sample times in the current mix) with its current state,
+// leaving mixTime at its next step
 
-			if (curFeedbackVolume) {
-				for (int i = 0; i < toMixSamples; i++) {
-					*bufferWrite += curFeedbackVolume;
-					++bufferWrite;
-				}
-			} else {
-				bufferWrite += toMixSamples;
-			}
+static void mix_pulse(nes_apu_pulse& pulse, int volume, unsigned int startTime, unsigned int endTime, unsigned int clockTime) {
+	if (pulse.sweepTargetPeriod > 0x7FF || pulse.lengthCounter == 0 || pulse.rawPeriod < 8)
+		volume = 0;
 
-			remainingLength -= toMixSamples;
-		}
+	if (volume == 0) {
+		mix_level<true>(pulse.mixLevel, startTime, 0);
+		hold_step(pulse.mixTime, endTime);
+		return;
+	}
+
+	const int* duty = pulse_duty[pulse.dutyCycle];
+	const unsigned int stepTime = mix_time(2 * (pulse.rawPeriod + 1), clockTime);
+	mix_level<true>(pulse.mixLevel, startTime, duty[pulse.mixStep] * volume);
+
+	unsigned int time = pulse.mixTime;
+	while (time < endTime) {
+		pulse.mixStep = (pulse.mixStep + 1) & 7;
+		mix_level<true>(pulse.mixLevel, time, duty[pulse.mixStep] * volume);
+		time += stepTime;
+	}
+	pulse.mixTime = time;
+}
+
+template<bool bBandLimited>
+static unsigned int step_triangle(nes_apu_triangle& triangle, int volume, unsigned int time, unsigned int endTime, unsigned int stepTime) {
+	while (time < endTime) {
+		triangle.mixStep = (triangle.mixStep + 1) & 31;
+		mix_level<bBandLimited>(triangle.mixLevel, time, tri_duty[triangle.mixStep] * volume);
+		time += stepTime;
+	}
+	return time;
+}
+
+static void mix_triangle(nes_apu_triangle& triangle, int volume, unsigned int startTime, unsigned int endTime, unsigned int clockTime) {
+	if (triangle.linearCounter == 0 || triangle.lengthCounter == 0 || triangle.rawPeriod < 2)
+		volume = 0;
+
+	const unsigned int stepTime = mix_time(triangle.rawPeriod + 1, clockTime);
+	mix_level<true>(triangle.mixLevel, startTime, tri_duty[triangle.mixStep] * volume);
+
+	// ultrasonic periods (several steps per sample) hold their step
+	if (volume == 0 || stepTime < 0x2000) {
+		hold_step(triangle.mixTime, endTime);
+		return;
+	}
+
+	if (stepTime >= (BLIP_TAPS << 16)) {
+		triangle.mixTime = step_triangle<true>(triangle, volume, triangle.mixTime, endTime, stepTime);
 	} else {
-		noise.clocks = 0;
+		triangle.mixTime = step_triangle<false>(triangle, volume, triangle.mixTime, endTime, stepTime);
 	}
+}
+
+static void mix_noise(nes_apu_noise& noise, int volume, unsigned int startTime, unsigned int endTime, unsigned int clockTime) {
+	if (noise.lengthCounter == 0)
+		volume = 0;
 
-	// dmc
-	if (dmc.samplesPerPeriod) {
-		int remainingLength = length;
-		int* bufferWrite = intoBuffer;
+	if (volume == 0) {
+		mix_level<false>(noise.mixLevel, startTime, 0);
+		noise.mixTime = endTime;
+		return;
+	}
 
-		while (remainingLength > 0) {
-			int dmcVolume = dmc.output * 96;
-			CHECK_ENABLED(dmc);
+	// shifting faster than the sample rate only makes the same white noise, so it is clamped at a sample per shift
+	unsigned int stepTime = mix_time(noise.period, clockTime);
+	if (stepTime < 0x10000) stepTime = 0x10000;
+	mix_level<false>(noise.mixLevel, startTime, (noise.shiftRegister & 1) ? 0 : volume);
 
-			int toMixClocks = dmc.samplesPerPeriod - dmc.clocks;
-			int toMixSamples = toMixClocks >> 4;
-			if (remainingLength < toMixSamples) {
-				toMixSamples = remainingLength;
-				dmc.clocks = (toMixSamples << 4);
-			} else {
-				dmc.step();
-				dmc.clocks = (toMixSamples << 4) - toMixClocks;
-			}
+	unsigned int time = noise.mixTime;
+	while (time < endTime) {
+		int feedback = noise.shiftRegister & 1;
+		if (noise.noiseMode)
+			feedback = feedback ^ ((noise.shiftRegister >> 6) & 1);
+		else
+			feedback = feedback ^ ((noise.shiftRegister >> 1) & 1);
+		noise.shiftRegister = (noise.shiftRegister >> 1) | (feedback << 14);
 
-			if (dmcVolume) {
-				if (bHighQuality) {
-					int dampenFactor = 256 - dmc.output * 160 / 256;
-					for (int i = 0; i < toMixSamples; i++) {
-						*bufferWrite += *bufferWrite * dampenFactor / 256 + dmcVolume;
-						// if DMC is being applied, then it's possible the total volume will clip, so keep it from wrapping
-						if (*bufferWrite > 16383) *bufferWrite = 16383;
-						++bufferWrite;
-					}
-				} else {
-					for (int i = 0; i < toMixSamples; i++) {
-						*bufferWrite += dmcVolume;
-						// if DMC is being applied, then it's possible the total volume will clip, so keep it from wrapping
-						if (*bufferWrite > 16383) *bufferWrite = 16383;
-						++bufferWrite;
-					}
-				}
-			} else {
-				bufferWrite += toMixSamples;
-			}
+		mix_level<false>(noise.mixLevel, time, (noise.shiftRegister & 1) ? 0 : volume);
+		time += stepTime;
+	}
+	noise.mixTime = time;
+}
 
-			remainingLength -= toMixSamples;
-		}
+template<bool bBandLimited>
+static unsigned int step_dmc(nes_apu_dmc& dmc, int volume, unsigned int time, unsigned int endTime, unsigned int stepTime) {
+	while (time < endTime) {
+		dmc.step();
+		mix_level<bBandLimited>(dmc.mixLevel, time, dmc.output * volume);
+		time += stepTime;
 	}
-	
-	int pulse1Volume = 210 * (pulse1.useConstantVolume ? pulse1.constantVolume : pulse1.envelopeVolume) / 4;
-	CHECK_ENABLED(pulse1);
+	return time;
+}
 
-	if (pulse1.sweepTargetPeriod > 0x7FF || pulse1.lengthCounter == 0 || pulse1.rawPeriod < 8)
-		pulse1Volume = 0;
+static void mix_dmc(nes_apu_dmc& dmc, int volume, unsigned int startTime, unsigned int endTime, unsigned int clockTime) {
+	if (dmc.period == 0) {
+		hold_step(dmc.mixTime, endTime);
+		return;
+	}
 
-	if (pulse1Volume) {
-		int pulse1_delta = duty_delta(pulse1.rawPeriod);
-		const int* pulse1_duty = pulse_duty[pulse1.dutyCycle];
+	const unsigned int stepTime = mix_time(dmc.period, clockTime);
+	mix_level<true>(dmc.mixLevel, startTime, dmc.output * volume);
 
-		for (int32 i = 0; i < length; i++) {
-			pulse1.mixOffset = (pulse1.mixOffset + pulse1_delta) & 0xFFFF;
-			intoBuffer[i] += pulse1_duty[(pulse1.mixOffset >> 12)] * pulse1Volume;
-		}
+	if (stepTime >= (BLIP_TAPS << 16)) {
+		dmc.mixTime = step_dmc<true>(dmc, volume, dmc.mixTime, endTime, stepTime);
+	} else {
+		dmc.mixTime = step_dmc<false>(dmc, volume, dmc.mixTime, endTime, stepTime);
 	}
-	
-	int pulse2Volume = 210 * (pulse2.useConstantVolume ? pulse2.constantVolume : pulse2.envelopeVolume) / 4;
+}
+
+// mixes every channel from the mix's copy of the generators over a run of the mix with no events
+static void mix_run(nes_apu& apu, unsigned int startTime, unsigned int endTime, unsigned int clockTime) {
+	nes_apu_generators& gen = apu.mixChannels;
+
+	int triVolume = 237;
+	CHECK_ENABLED(tri);
+	mix_triangle(gen.triangle, triVolume, startTime, endTime, clockTime);
+
+	int noiseVolume = 138 * (gen.noise.useConstantVolume ? gen.noise.constantVolume : gen.noise.envelopeVolume);
+	CHECK_ENABLED(noise);
+	mix_noise(gen.noise, noiseVolume, startTime, endTime, clockTime);
+
+	int dmcVolume = 96;
+	CHECK_ENABLED(dmc);
+	mix_dmc(apu.dmc, dmcVolume, startTime, endTime, clockTime);
+
+	int pulse1Volume = 210 * (gen.pulse1.useConstantVolume ? gen.pulse1.constantVolume : gen.pulse1.envelopeVolume);
+	CHECK_ENABLED(pulse1);
+	mix_pulse(gen.pulse1, pulse1Volume, startTime, endTime, clockTime);
+
+	int pulse2Volume = 210 * (gen.pulse2.useConstantVolume ? gen.pulse2.constantVolume : gen.pulse2.envelopeVolume);
 	CHECK_ENABLED(pulse2);
+	mix_pulse(gen.pulse2, pulse2Volume, startTime, endTime, clockTime);
+}
 
-	if (pulse2.sweepTargetPeriod > 0x7FF || pulse2.lengthCounter == 0 || pulse2.rawPeriod < 8)
-		pulse2Volume = 0;
+void nes_apu::mix(int* intoBuffer, int length) {
+	TIME_SCOPE();
 
-	if (pulse2Volume) {
-		int delta = duty_delta(pulse2.rawPeriod);
-		const int* duty = pulse_duty[pulse2.dutyCycle];
+	// the delta buffer holds a limited number of samples, so longer mixes are split with their share of the CPU clocks
+	const cpu_clock toClocks = mainCPU.clocks;
+	while (length > BLIP_MAX_SAMPLES) {
+		const unsigned int chunkClocks = (unsigned int)(toClocks - mixClocks) / length * BLIP_MAX_SAMPLES;
+		mixSamples(intoBuffer, BLIP_MAX_SAMPLES, mixClocks + chunkClocks);
+		intoBuffer += BLIP_MAX_SAMPLES;
+		length -= BLIP_MAX_SAMPLES;
+	}
+	mixSamples(intoBuffer, length, toClocks);
 
-		for (int32 i = 0; i < length; i++) {
-			pulse2.mixOffset = (pulse2.mixOffset + delta) & 0xFFFF;
-			intoBuffer[i] += duty[(pulse2.mixOffset >> 12)] * pulse2Volume;
-		}
+	// events at (or somehow past) the current clock start the next mix
+	while (eventsMixed != eventsQueued) {
+		applyEvent(events[eventsMixed++ & (APU_EVENT_QUEUE_SIZE - 1)]);
 	}
+}
 
+void nes_apu::mixSamples(int* intoBuffer, int length, cpu_clock toClocks) {
+	const unsigned int endTime = length << 16;
+	const unsigned int clockTime = nesCart.isPAL ? palClockTime : ntscClockTime;
+
+	// queued events are placed by their share of the CPU clocks since the last mix, so they land where they happened
+	// however far the emulation is ahead of or behind the sound, and the runs between them are mixed in order
+	const unsigned int spanClocks = (unsigned int)(toClocks - mixClocks);
+	const unsigned int eventTime = spanClocks ? endTime / spanClocks : 0;		// sample time (16.16) per CPU clock
+	unsigned int startTime = 0;
+	while (eventsMixed != eventsQueued) {
+		const nes_apu_event& event = events[eventsMixed & (APU_EVENT_QUEUE_SIZE - 1)];
+		const unsigned int eventClocks = (unsigned int)(event.clocks - mixClocks);
+		if (eventClocks >= spanClocks)
+			break;
 
-	if (bHighQuality) {
-		// remove any sudden spikes/dips
-		int32 maxSpike = 8192;
-		for (int32 i = 1; i < length - 1; i++) {
-			if (intoBuffer[i] - intoBuffer[i - 1] > maxSpike &&
-				intoBuffer[i] - intoBuffer[i + 1] > maxSpike) {
-				intoBuffer[i] = (intoBuffer[i - 1] + intoBuffer[i + 1]) / 2;
-			} 
-			else if (intoBuffer[i-1] - intoBuffer[i] > maxSpike &&
-				intoBuffer[i+1] - intoBuffer[i] > maxSpike) {
-				intoBuffer[i] = (intoBuffer[i - 1] + intoBuffer[i + 1]) / 2;
-			}
+		const unsigned int time = eventClocks * eventTime;
+		if (time > startTime) {
+			mix_run(*this, startTime, time, clockTime);
+			startTime = time;
 		}
-		
-		// low pass filter
-		int lastSample = intoBuffer[0];
-		for (int32 i = 1; i < length; i++) {
-			intoBuffer[i] = lastSample * 16 / 128 + intoBuffer[i] * 112 / 128;
-			lastSample = intoBuffer[i];
+
+		applyEvent(event);
+		eventsMixed++;
+	}
+	mix_run(*this, startTime, endTime, clockTime);
+	mixClocks = toClocks;
+
+	// next steps are relative to the next mix
+	mixChannels.pulse1.mixTime -= endTime;
+	mixChannels.pulse2.mixTime -= endTime;
+	mixChannels.triangle.mixTime -= endTime;
+	mixChannels.noise.mixTime -= endTime;
+	dmc.mixTime -= endTime;
+
+	// integrate the deltas into samples, clearing them for the next mix
+	int level = blip_level;
+	for (int32 i = 0; i < length; i++) {
+		level += blip_deltas[i];
+		blip_deltas[i] = 0;
+
+		// the total volume may clip (mostly with the DMC), and band limited steps overshoot, so keep it from wrapping
+		int sample = level >> BLIP_BITS;
+		if ((unsigned int) sample > 16383) {
+			sample = sample < 0 ? 0 : 16383;
 		}
+		intoBuffer[i] = sample;
 	}
-}
\ No newline at end of file
+	blip_level = level;
+
+	// impulses past the end begin the next mix
+	for (int32 i = 0; i < BLIP_TAPS; i++) {
+		blip_deltas[i] = blip_deltas[length + i];
+		blip_deltas[length + i] = 0;
+	}
+}
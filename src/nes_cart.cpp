@@ -52,6 +52,47 @@ void nes_cart::allocateBanks(unsigned char* staticAlloced) {
 	}
 }
 
+void nes_cart::allocateDecodedBanks() {
+	DebugAssert(numDecodedBanks == 0);
+
+	// the reserve is held while allocating so the tables always leave that much heap free while in game
+	void* reserve = malloc(DECODED_HEAP_RESERVE);
+	if (reserve == nullptr)
+		return;
+
+	for (int i = 0; i < MAX_DECODED_PRG_BANKS; i++) {
+		nes_decoded_op* decodedBank = (nes_decoded_op*) malloc(8192 * sizeof(nes_decoded_op));
+		if (decodedBank) {
+			decodedBanks[numDecodedBanks++] = decodedBank;
+		} else {
+			break;
+		}
+	}
+
+	free(reserve);
+
+	// give the mapped banks their tables
+	for (int i = 0; i < 4; i++) {
+		if (programBanks[i] >= 0) {
+			nes_decoded_op* decoded;
+			cachePRGBank(programBanks[i], &decoded);
+			mainCPU.decodedMap[4 + i] = decoded;
+		}
+	}
+}
+
+void nes_cart::freeDecodedBanks() {
+	memset(mainCPU.decodedMap, 0, sizeof(mainCPU.decodedMap));
+	for (int i = 0; i < availableROMBanks; i++) {
+		cache[i].decodedSlot = -1;
+	}
+
+	for (int i = 0; i < numDecodedBanks; i++) {
+		free(decodedBanks[i]);
+	}
+	numDecodedBanks = 0;
+}
+
 bool nes_cart::loadROM(const char* withFile) {
 	DebugAssert(handle <= 0);
 
@@ -237,6 +278,9 @@ bool nes_cart::loadROM(const char* withFile) {
 	// mapper logic
 	handle = file;
 	if (setupMapper()) {
+		// the renderer depends on whether the mapper has render latches
+		nesPPU.selectRenderScanline();
+
 		strcpy(romFile, withFile);
 		printf("Mapper %d : supported", mapper);
 		return true;
@@ -326,6 +370,7 @@ bool nes_cart::setupMapper() {
 	clearCacheData();
 
 	memset(registers, 0, sizeof(registers));
+	memset(clockRegisters, 0, sizeof(clockRegisters));
 	memset(programBanks, 0xFF, sizeof(programBanks));
 	memset(chrBanks, 0xFF, sizeof(chrBanks));
 
@@ -438,6 +483,8 @@ void nes_cart::clearCacheData() {
 	}
 
 	cachedBankCount = 0;
+
+	memset(mainCPU.decodedMap, 0, sizeof(mainCPU.decodedMap));
 }
 
 // returns whether the bank given is in use by the memory map
@@ -458,6 +505,9 @@ bool nes_cart::isBankUsed(int index) {
 
 // finds least recently requested bank that is currently unused
 int nes_cart::findOldestUnusedBank() {
+	// the replaced bank may still be rendered from by queued lines
+	nesPPU.syncRender();
+
 	int bestBank = -1;
 	for (int i = 0; i < cachedBankCount; i++) {
 		if (bestBank == -1 || cache[i].request < cache[bestBank].request) {
@@ -475,26 +525,79 @@ int nes_cart::findOldestUnusedBank() {
 	return bestBank;
 }
 
+// returns a decoded op table slot that isn't owned by a currently mapped bank (cleared to DECODED_OP_EMPTY), or -1 if none
+int nes_cart::claimDecodedSlot() {
+	int bestSlot = -1;
+	int bestOwner = -1;
+	for (int slot = 0; slot < numDecodedBanks; slot++) {
+		int owner = -1;
+		for (int i = 0; i < cachedBankCount; i++) {
+			if (cache[i].decodedSlot == slot) {
+				owner = i;
+				break;
+			}
+		}
+
+		if (owner == -1) {
+			bestSlot = slot;
+			bestOwner = -1;
+			break;
+		}
+
+		// otherwise steal from the least recently requested bank that isn't mapped
+		if (isBankUsed(owner) == false && (bestSlot == -1 || cache[owner].request < cache[bestOwner].request)) {
+			bestSlot = slot;
+			bestOwner = owner;
+		}
+	}
+
+	if (bestSlot != -1) {
+		if (bestOwner != -1) {
+			cache[bestOwner].decodedSlot = -1;
+		}
+		memset(decodedBanks[bestSlot], DECODED_OP_EMPTY, 8192 * sizeof(nes_decoded_op));
+	}
+
+	return bestSlot;
+}
+
 // caches an 8 KB PRG bank (so index up to 2 * numPRGBanks), returns result bank memory pointer
-unsigned char* nes_cart::cachePRGBank(int index) {
+unsigned char* nes_cart::cachePRGBank(int index, nes_decoded_op** decoded) {
 	DebugAssert(index < numPRGBanks * 2);
 
 	requestIndex++;
 
 	// find bank index within range:
+	int bankIndex = -1;
 	for (int i = 0; i < cachedBankCount; i++) {
 		if (cache[i].prgIndex == index) {
 			cache[i].request = requestIndex;
-			return cache[i].ptr;
+			bankIndex = i;
+			break;
 		}
 	}
 
-	// replace smallest request with inactive memory
-	int replaceIndex = findOldestUnusedBank();
-	cache[replaceIndex].prgIndex = index;
-	cache[replaceIndex].request = requestIndex;
-	BlockRead(cache[replaceIndex].ptr, 8192, 16 + 8192 * index);
-	return cache[replaceIndex].ptr;
+	if (bankIndex == -1) {
+		// replace smallest request with inactive memory
+		bankIndex = findOldestUnusedBank();
+		cache[bankIndex].prgIndex = index;
+		cache[bankIndex].request = requestIndex;
+		BlockRead(cache[bankIndex].ptr, 8192, 16 + 8192 * index);
+
+		// any ops decoded from the previous contents are stale
+		if (cache[bankIndex].decodedSlot != -1) {
+			memset(decodedBanks[cache[bankIndex].decodedSlot], DECODED_OP_EMPTY, 8192 * sizeof(nes_decoded_op));
+		}
+	}
+
+	if (decoded) {
+		if (cache[bankIndex].decodedSlot == -1) {
+			cache[bankIndex].decodedSlot = claimDecodedSlot();
+		}
+		*decoded = cache[bankIndex].decodedSlot != -1 ? decodedBanks[cache[bankIndex].decodedSlot] : nullptr;
+	}
+
+	return cache[bankIndex].ptr;
 }
 
 // caches an 8 KB CHR bank, returns result bank memory pointer
@@ -532,10 +635,13 @@ unsigned char* nes_cart::cacheCHRBank(int16* indices) {
 	nes_cached_bank& bank = cache[replaceIndex];
 	bank.prgIndex = cacheIndex;
 	bank.request = requestIndex;
+	bank.decodedSlot = -1;
 	for (int32 i = 0; i < 8; i++) {
 		bank.chrIndex[i] = indices[i];
 		BlockRead(bank.ptr + 1024 * i, 1024, 16 + 16384 * numPRGBanks + 1024 * indices[i]);
 	}
+	nesPPU.invalidateRenderedMemory();
+	nesPPU.invalidateDecodedCHR(bank.ptr, 8192);
 	return bank.ptr;
 }
 
@@ -560,7 +666,14 @@ void nes_cart::MapProgramBanks(int32 toBank, int32 cartBank, int32 numBanks) {
 		const int32 destBank = i + toBank;
 		if (programBanks[destBank] != cartBank + i) {
 			programBanks[destBank] = cartBank + i;
-			mainCPU.setMapKB(addrTarget[destBank], 8, cachePRGBank(cartBank + i));
+			if (destBank < 4) {
+				nes_decoded_op* decoded;
+				mainCPU.setMapKB(addrTarget[destBank], 8, cachePRGBank(cartBank + i, &decoded));
+				mainCPU.decodedMap[addrTarget[destBank] >> 5] = decoded;
+			} else {
+				// low PRG ROM at 0x6000 shares its address space with WRAM so isn't decoded
+				mainCPU.setMapKB(addrTarget[destBank], 8, cachePRGBank(cartBank + i));
+			}
 			bDidRemap = true;
 		}
 	}
@@ -574,6 +687,14 @@ void nes_cart::MapProgramBanks(int32 toBank, int32 cartBank, int32 numBanks) {
 				unsigned char* memValue = mainCPU.getNonIOMem(addr);
 				if ((size_t) memValue >= 0x10000 && (nesSettings.codes[code].doCompare() == false || nesSettings.codes[code].getCmpValue() == *memValue)) {
 					*memValue = setValue;
+
+					// the patched byte may already be decoded as part of an instruction
+					nes_decoded_op* decoded = mainCPU.decodedMap[(addr >> 13) & 7];
+					if (decoded) {
+						for (unsigned int b = 0; b < MAX_DECODED_OP_SIZE && b <= (addr & 0x1FFF); b++) {
+							decoded[(addr & 0x1FFF) - b].clocks = DECODED_OP_EMPTY;
+						}
+					}
 				}
 			} else {
 				break;
@@ -585,6 +706,8 @@ void nes_cart::MapProgramBanks(int32 toBank, int32 cartBank, int32 numBanks) {
 void nes_cart::CommitChrBanks() {
 	DebugAssert(numCHRBanks); // should not happen with CHR RAM
 
+	nesPPU.catchUp();
+
 	uint8* bankData = cacheCHRBank(chrBanks);
 
 	if (bSwapChrPages) {
@@ -614,7 +737,7 @@ bool nes_cart::IRQReached() {
 	if (mapper == 64) {
 		if (Mapper64_IRQ_MODE == 1) {
 			// set next IRQ breakpoint
-			Mapper64_IRQ_CLOCKS = mainCPU.irqClock[0] + Mapper64_IRQ_COUNT + 4;
+			Mapper64_IRQ_CLOCKS = mainCPU.eventClocks[EVENT_IRQ0] + Mapper64_IRQ_COUNT + 4;
 			if (Mapper64_IRQ_ENABLE) {
 				mainCPU.setIRQ(0, Mapper64_IRQ_CLOCKS);
 				return true;
@@ -647,19 +770,3 @@ bool nes_cart::IRQReached() {
 
 	return true;
 }
-
-void nes_cart::rollbackClocks(unsigned int clockCount) {
-	if (mapper == 4) {
-		MMC3_IRQ_LASTSET -= clockCount;
-	} else if (mapper == 64) {
-		if (Mapper64_IRQ_CLOCKS) {
-			Mapper64_IRQ_CLOCKS -= clockCount;
-		}
-	} else if (mapper == 67) {
-		Mapper67_IRQ_LastSet -= clockCount;
-	} else if (mapper == 69) {
-		if (Mapper69_LASTCOUNTERCLK) {
-			Mapper69_LASTCOUNTERCLK -= clockCount;
-		}
-	}
-}
\ No newline at end of file
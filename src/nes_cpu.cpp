@@ -65,7 +65,8 @@ void nes_cpu::mapDefaults() {
 // reset the CPU (assumes memory mapping is set up properly for this)
 void nes_cpu::reset() {
 	// CPU set to match FCEUX for debugging
-	ppuNMI = false;
+	numEvents = 0;
+	eventMask = 0;
 
 	// RAM reset
 	for (int i = 0; i < 0x800; i += 8) {
@@ -89,19 +90,22 @@ void nes_cpu::reset() {
 	SP = 0xFD;
 
 	clocks = 0;
+	nextClocks = 0;
 
 	// comparing to FCEUX we appear to be just slightly ahead on clocks
-	ppuClocks = 2510;
-
-	// start with apuClocks in one frame
-	apuClocks = 7458;
-	
-	// all irqs high
-	irqMask = 0;
-	irqClock[0] = 0;
-	irqClock[1] = 0;
-	irqClock[2] = 0;
-	irqClock[3] = 0;
+	schedule(EVENT_PPU, 2510);
+
+	// start with the APU step in one frame
+	schedule(EVENT_APU, 7458);
+
+	// all irqs high (none scheduled)
+
+	idleBranchPC = 0x10000;
+	idleBranchClocks = 0;
+	idleLoopClocks = 0;
+	idleClocksSkipped = 0;
+
+	cpu6502_ProfileReset();
 
 	// trigger reset interrupt
 	cpu6502_SoftwareInterrupt(0xFFFC);
@@ -121,19 +125,97 @@ void cpu6502_IRQ(int irqBit) {
 	}
 }
 
-void nes_cpu::syncClocks() {
-	// at a billion cycles, reduve by 500m cycles
-	const unsigned int highThresh =  1000000000;
-	const unsigned int reduction = 500000000;
-	if (clocks > highThresh) {
-		clocks -= reduction;
-		nextClocks -= reduction;
-		ppuClocks -= reduction;
-		apuClocks -= reduction;
-		if (irqClock[0]) irqClock[0] -= reduction;
-		if (irqClock[1]) irqClock[0] -= reduction;
-		if (irqClock[2]) irqClock[0] -= reduction;
-
-		nesCart.rollbackClocks(reduction);
+void nes_cpu::schedule(int event, cpu_clock atClocks) {
+	if (eventMask & EVENT_BIT(event)) {
+		cancel(event);
 	}
-}
\ No newline at end of file
+
+	// insert sorted, after any events at the same clocks with higher priority
+	unsigned int i = numEvents;
+	for (; i > 0; i--) {
+		const unsigned int prev = eventQueue[i - 1];
+		if (CLOCKS_BEFORE(eventClocks[prev], atClocks) || (eventClocks[prev] == atClocks && prev < (unsigned int) event))
+			break;
+		eventQueue[i] = prev;
+	}
+	eventQueue[i] = event;
+	eventClocks[event] = atClocks;
+	eventMask |= EVENT_BIT(event);
+	numEvents++;
+
+	// masked IRQs don't stop the cpu
+	if (CLOCKS_BEFORE(atClocks, nextClocks) && ((P & ST_INT) == 0 || (EVENT_BIT(event) & EVENT_IRQ_BITS) == 0)) {
+		nextClocks = atClocks;
+	}
+}
+
+void nes_cpu::cancel(int event) {
+	if (!(eventMask & EVENT_BIT(event)))
+		return;
+
+	unsigned int i = 0;
+	while (eventQueue[i] != event) i++;
+	for (numEvents--; i < numEvents; i++) {
+		eventQueue[i] = eventQueue[i + 1];
+	}
+	eventMask &= ~EVENT_BIT(event);
+}
+
+static void ServiceNMI() {
+	mainCPU.cancel(EVENT_NMI);
+	mainCPU.NMI();
+}
+
+static void ServicePPU() {
+	nesPPU.step();
+}
+
+static void ServiceAPU() {
+	nesAPU.step();
+}
+
+static void ServiceIRQ0() {
+	cpu6502_IRQ(0);
+}
+
+static void ServiceIRQ1() {
+	cpu6502_IRQ(1);
+}
+
+static void ServiceIRQ2() {
+	cpu6502_IRQ(2);
+}
+
+static void ServiceIRQ3() {
+	cpu6502_IRQ(3);
+}
+
+typedef void(*eventHandler)();
+static const eventHandler eventHandlers[NUM_EVENTS] = {
+	ServiceNMI,
+	ServicePPU,
+	ServiceAPU,
+	ServiceIRQ0,
+	ServiceIRQ1,
+	ServiceIRQ2,
+	ServiceIRQ3
+};
+
+void nes_cpu::runStep() {
+	cpu6502_Step();
+
+	// service each due event once in clock order. Handlers reschedule themselves (or other events), so the queue is
+	// rescanned from the front after each. IRQs remain in the queue until acknowledged
+	unsigned int serviced = 0;
+	for (unsigned int i = 0; i < numEvents && !CLOCKS_BEFORE(clocks, eventClocks[eventQueue[i]]);) {
+		const unsigned int event = eventQueue[i];
+		if (serviced & EVENT_BIT(event)) {
+			i++;
+			continue;
+		}
+
+		serviced |= EVENT_BIT(event);
+		eventHandlers[event]();
+		i = 0;
+	}
+}
@@ -3,18 +3,79 @@
 
 extern unsigned char openBus[256];
 
+// timed events the cpu runs against. Events due on the same clock are serviced in this order
+enum nes_event {
+	EVENT_NMI,		// pending NMI, serviced when the cpu stops at (or before) this time
+	EVENT_PPU,		// next PPU scanline step
+	EVENT_APU,		// next APU frame counter step
+	EVENT_IRQ0,		// IRQ lines (0 is cart IRQ, 1-2 APU IRQ), held until acknowledged and only stop the cpu while
+	EVENT_IRQ1,		// interrupts are enabled
+	EVENT_IRQ2,
+	EVENT_IRQ3,
+
+	NUM_EVENTS
+};
+
+#define EVENT_BIT(event) (1 << (event))
+#define EVENT_IRQ_BITS (EVENT_BIT(EVENT_IRQ0) | EVENT_BIT(EVENT_IRQ1) | EVENT_BIT(EVENT_IRQ2) | EVENT_BIT(EVENT_IRQ3))
+
 struct nes_cpu : public cpu_6502 {
 	// each 8 KB page access is stored to determine if we need to effect hardware from a read
 	unsigned int accessTable[8];
 
-	// clocks for next PPU update
-	unsigned int ppuClocks;
+	// event queue : clocks for each scheduled event, and the scheduled events sorted by clocks (fixed capacity of one
+	// entry per event type, so rescheduling moves the existing entry)
+	cpu_clock eventClocks[NUM_EVENTS];
+	unsigned char eventQueue[NUM_EVENTS];
+	unsigned int numEvents;
+	unsigned int eventMask;
+
+	// schedules (or moves) the given event to the given clocks, and shortens the current cpu run if it is sooner
+	void schedule(int event, cpu_clock atClocks);
+
+	// removes the given event from the queue if it is scheduled
+	void cancel(int event);
+
+	FORCE_INLINE bool isScheduled(int event) const {
+		return (eventMask & EVENT_BIT(event)) != 0;
+	}
+
+	// clocks the cpu may run to before servicing an event (IRQs are skipped while interrupts are disabled)
+	FORCE_INLINE cpu_clock firstEventClocks() const {
+		const unsigned int skipMask = (P & ST_INT) ? EVENT_IRQ_BITS : 0;
+		for (unsigned int i = 0; i < numEvents; i++) {
+			if (!(skipMask & EVENT_BIT(eventQueue[i])))
+				return eventClocks[eventQueue[i]];
+		}
+		DebugAssert(false);
+		return clocks + 1;
+	}
+
+	// set the irq for the given irq number (atClocks = clocks to immediately trigger)
+	FORCE_INLINE void setIRQ(int irqNum, cpu_clock atClocks) {
+		// don't set clocks forward if already acknowledged
+		const int event = EVENT_IRQ0 + irqNum;
+		if (isScheduled(event) && CLOCKS_BEFORE(eventClocks[event], atClocks))
+			return;
 
-	// clocks for next APU update
-	unsigned int apuClocks;
+		schedule(event, atClocks);
+	}
+
+	// acknowledge the given irq number
+	FORCE_INLINE void ackIRQ(int irqNum) {
+		cancel(EVENT_IRQ0 + irqNum);
+	}
 
-	// indicates that an NMI should occur on completion of next cpu instruction
-	bool ppuNMI;
+	// idle loop detection state (last short backward branch taken, the clock it was taken at, and its loop clocks if idle)
+	unsigned int idleBranchPC;
+	cpu_clock idleBranchClocks;
+	unsigned int idleLoopClocks;
+
+	// stats : clocks skipped by idle loop detection since the ROM was loaded or reset
+	unsigned long long idleClocksSkipped;
+
+	// runs the cpu to its next scheduled event, then services any PPU/APU/IRQ events that are due (one iteration of the game loop)
+	void runStep();
 
 	void latchedSpecial(unsigned int addr);
 
@@ -29,6 +90,9 @@ struct nes_cpu : public cpu_6502 {
 	// memory map for special address (mirrored from 0x4000 to 0x6000)
 	unsigned char specialMemory[256];
 
+	// decoded op table per 8 KB of address space. Only set for PRG ROM mapped from 0x8000, code in RAM/WRAM is always decoded as it runs
+	nes_decoded_op* decodedMap[8];
+
 	FORCE_INLINE unsigned char read(unsigned int addr) {
 		accessTable[addr >> 13] = addr;
 		return _map[addr >> 8][addr];
@@ -102,7 +166,4 @@ struct nes_cpu : public cpu_6502 {
 
 	// reset the CPU (assumes memory mapping is set up properly for this)
 	void reset();
-
-	// synchronizes the various clock counters down to avoid 32 bit wraparound
-	void syncClocks();
 };
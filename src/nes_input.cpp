@@ -7,7 +7,7 @@
 #include "settings.h"
 #include "nes_cpu.h"
 
-#if !TARGET_WINSIM
+#if !TARGET_WINSIM && !TARGET_HOST
 // returns true if the key is down, false if up
 bool keyDown_fast(unsigned char keyCode) {
 	static const unsigned short* keyboard_register = (unsigned short*)0xA44B0000;
@@ -22,6 +22,7 @@ typedef struct HsvColor
 
 RgbColor HsvToRgb(HsvColor hsv);
 HsvColor RgbToHsv(RgbColor rgb);
+static uint16 EmphasizeColor(uint16 color, uint32 emph);
 
 // harcoded palettes defined at the bottom of the file
 extern const uint8 fceuxPalette[64 * 3];
@@ -104,78 +105,92 @@ void nes_ppu::initPalette() {
 			((min(g + 2, 255) >> 2) << 5) |
 			((min(b + 4, 255) >> 3) << 0);
 	}
+
+	// every combination of emphasis bits, so switching them or rewriting palette memory is just a gather
+	for (int e = 0; e < 8; e++) {
+		for (int c = 0; c < 64; c++) {
+			emphasisPalettes[e][c] = e ? EmphasizeColor(rgbPalette[c], e << 5) : rgbPalette[c];
+		}
+	}
+
+	dirtyPalette = true;
 }
 
-// resolves base palette to our working palette based on selected indices for sprites and backgrounds, while
-// also applying emphasis bits as requested
+// channel scales for emphasis, indexed by a 5 bit channel value
+static const uint16 ShiftUpTable[32] =
+{
+	0b00000, 0b00010, 0b00100, 0b00110, 0b01000, 0b01010, 0b01100, 0b01110,
+	0b10000, 0b10010, 0b10100, 0b10110, 0b11000, 0b11010, 0b11100, 0b11110,
+	0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111,
+	0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111,
+};
+static const uint16 ShiftNoneTable[32] =
+{
+	0b00000, 0b00001, 0b00010, 0b00011, 0b00100, 0b00101, 0b00110, 0b00111,
+	0b01000, 0b01001, 0b01010, 0b01011, 0b01100, 0b01101, 0b01110, 0b01111,
+	0b10000, 0b10001, 0b10010, 0b10011, 0b10100, 0b10101, 0b10110, 0b10111,
+	0b11000, 0b11001, 0b11010, 0b11011, 0b11100, 0b11101, 0b11110, 0b11111,
+};
+static const uint16 ShiftDownTable[32] =
+{
+	0b00000, 0b00001, 0b00010, 0b00010, 0b00011, 0b00100, 0b00101, 0b00101,
+	0b00110, 0b00111, 0b01000, 0b01000, 0b01001, 0b01010, 0b01011, 0b01011,
+	0b01100, 0b01101, 0b01110, 0b01110, 0b01111, 0b10000, 0b10001, 0b10001,
+	0b10010, 0b10011, 0b10100, 0b10100, 0b10101, 0b10110, 0b10111, 0b10111,
+};
+static const uint16 ShiftDown2Table[32] =
+{
+	0b00000, 0b00001, 0b00001, 0b00001, 0b00010, 0b00010, 0b00011, 0b00011,
+	0b00100, 0b00100, 0b00101, 0b00101, 0b00110, 0b00110, 0b00111, 0b00111,
+	0b01000, 0b01000, 0b01001, 0b01001, 0b01010, 0b01010, 0b01011, 0b01011,
+	0b01100, 0b01100, 0b01101, 0b01101, 0b01110, 0b01110, 0b01111, 0b01111,
+};
+
+// applies emphasis bits (PPUMASK_EMPHRED etc) to a 565 color, brightening the emphasized channels and darkening the rest
+static uint16 EmphasizeColor(uint16 color, uint32 emph) {
+	int shiftRed = 1;
+	int shiftGreen = 1;
+	int shiftBlue = 1;
+	if (emph & PPUMASK_EMPHRED) {
+		shiftRed -= 1;
+		shiftGreen += 1;
+		shiftBlue += 1;
+	}
+	if (emph & PPUMASK_EMPHGREEN) {
+		shiftRed += 1;
+		shiftGreen -= 1;
+		shiftBlue += 1;
+	}
+	if (emph & PPUMASK_EMPHBLUE) {
+		shiftRed += 1;
+		shiftGreen += 1;
+		shiftBlue -= 1;
+	}
+
+	const uint16* ShiftTables[5] = { ShiftUpTable, ShiftNoneTable, ShiftDownTable, ShiftDown2Table, ShiftDown2Table };
+
+	return
+		(ShiftTables[shiftRed + 1][(color & 0b1111100000000000) >> 11] << 11) |
+		(ShiftTables[shiftGreen + 1][(color & 0b0000011111000000) >> 6] << 6) |
+		(color & 0b0000000000100000) |
+		ShiftTables[shiftBlue + 1][color & 0b0000000000011111];
+}
+
+// resolves base palette to our working palette based on selected indices for sprites and backgrounds, using the
+// precomputed palette for the emphasis bits and the gray column for grayscale
 void nes_ppu::resolveWorkingPalette() {
+	const uint16* srcPalette = emphasisPalettes[(PPUMASK & (PPUMASK_EMPHRED | PPUMASK_EMPHGREEN | PPUMASK_EMPHBLUE)) >> 5];
+	const unsigned int colorMask = (PPUMASK & PPUMASK_GRAYSCALE) ? 0x30 : 0x3F;
+
+	const uint16 background = srcPalette[palette[0] & colorMask];
 	for (int i = 0; i < 0x20; i++) {
-		if (i & 3) {
-			workingPalette[i] = rgbPalette[palette[i]];
-		} else {
-			workingPalette[i] = rgbPalette[palette[0]];
-		}
+		workingPalette[i] = (i & 3) ? srcPalette[palette[i] & colorMask] : background;
 	}
 
-	// emphasis bits
-	uint32 emph = PPUMASK & (PPUMASK_EMPHRED | PPUMASK_EMPHGREEN | PPUMASK_EMPHBLUE);
-	if (emph) {
-		int shiftRed = 1;
-		int shiftGreen = 1;
-		int shiftBlue = 1;
-		if (emph & PPUMASK_EMPHRED) {
-			shiftRed -= 1;
-			shiftGreen += 1;
-			shiftBlue += 1;
-		}
-		if (emph & PPUMASK_EMPHGREEN) {
-			shiftRed += 1;
-			shiftGreen -= 1;
-			shiftBlue += 1;
-		}
-		if (emph & PPUMASK_EMPHBLUE) {
-			shiftRed += 1;
-			shiftGreen += 1;
-			shiftBlue -= 1;
-		}
-
-		const uint16 ShiftUpTable[32] =
-		{
-			0b00000, 0b00010, 0b00100, 0b00110, 0b01000, 0b01010, 0b01100, 0b01110,
-			0b10000, 0b10010, 0b10100, 0b10110, 0b11000, 0b11010, 0b11100, 0b11110,
-			0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111,
-			0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111,
-		};
-		const uint16 ShiftNoneTable[32] =
-		{
-			0b00000, 0b00001, 0b00010, 0b00011, 0b00100, 0b00101, 0b00110, 0b00111,
-			0b01000, 0b01001, 0b01010, 0b01011, 0b01100, 0b01101, 0b01110, 0b01111,
-			0b10000, 0b10001, 0b10010, 0b10011, 0b10100, 0b10101, 0b10110, 0b10111,
-			0b11000, 0b11001, 0b11010, 0b11011, 0b11100, 0b11101, 0b11110, 0b11111,
-		};
-		const uint16 ShiftDownTable[32] =
-		{
-			0b00000, 0b00001, 0b00010, 0b00010, 0b00011, 0b00100, 0b00101, 0b00101,
-			0b00110, 0b00111, 0b01000, 0b01000, 0b01001, 0b01010, 0b01011, 0b01011,
-			0b01100, 0b01101, 0b01110, 0b01110, 0b01111, 0b10000, 0b10001, 0b10001,
-			0b10010, 0b10011, 0b10100, 0b10100, 0b10101, 0b10110, 0b10111, 0b10111,
-		};
-		const uint16 ShiftDown2Table[32] =
-		{
-			0b00000, 0b00001, 0b00001, 0b00001, 0b00010, 0b00010, 0b00011, 0b00011,
-			0b00100, 0b00100, 0b00101, 0b00101, 0b00110, 0b00110, 0b00111, 0b00111,
-			0b01000, 0b01000, 0b01001, 0b01001, 0b01010, 0b01010, 0b01011, 0b01011,
-			0b01100, 0b01100, 0b01101, 0b01101, 0b01110, 0b01110, 0b01111, 0b01111,
-		};
-		const uint16* ShiftTables[5] = { ShiftUpTable, ShiftNoneTable, ShiftDownTable, ShiftDown2Table, ShiftDown2Table };
-
-		for (int32 i = 0; i < 0x20; i++) {
-			workingPalette[i] =
-				(ShiftTables[shiftRed + 1][(workingPalette[i] & 0b1111100000000000) >> 11] << 11) |
-				(ShiftTables[shiftGreen + 1][(workingPalette[i] & 0b0000011111000000) >> 6] << 6) |
-				(workingPalette[i] & 0b0000000000100000) |
-				ShiftTables[shiftBlue + 1][workingPalette[i] & 0b0000000000011111];
-		}
+	// so resolved lines change with the palette
+	workingPaletteHash = 2166136261u;
+	for (int32 i = 0; i < 0x20; i++) {
+		workingPaletteHash = (workingPaletteHash ^ workingPalette[i]) * 16777619;
 	}
 
 	dirtyPalette = false;
@@ -10,6 +10,11 @@
 #include "scope_timer/scope_timer.h"
 #include "frontend.h"
 
+#if TARGET_HOST
+#include "host/host_simd.h"
+#include "host/host_render_thread.h"
+#endif
+
 #if TRACE_DEBUG
 static unsigned int ppuWriteBreakpoint = 0x10000;
 extern void PPUBreakpoint();
@@ -17,38 +22,91 @@ extern void PPUBreakpoint();
 
 nes_ppu nesPPU;
 
-static uint16 reverseBytelookup[16] = {
-	0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
-	0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
-};
+uint8 spriteLines[SPRITE_LINES][8];
+uint8 spriteLineCount[SPRITE_LINES];
+uint8 spriteLineOverflow[SPRITE_LINES];
+
+// adds the sprite at the given OAM offset with the given Y to the scanline sprite lists (in OAM order, so the first 8 on
+// each line are the ones the PPU would evaluate)
+template<int spriteSize>
+static inline void AddSpriteLines(unsigned int sprite, unsigned int y) {
+	const int scanlineOffset = 2;
+
+	unsigned int line = y + scanlineOffset;
+	unsigned int lastLine = line + spriteSize;
+	if (lastLine > SPRITE_LINES) {
+		lastLine = SPRITE_LINES;
+	}
 
-uint16 reverseByte(uint16 b) {
-	// Reverse the top and bottom nibble then swap them.
-	return (reverseBytelookup[b & 0xF] << 4) | reverseBytelookup[b >> 4];
+	for (; line < lastLine; line++) {
+		const unsigned int count = spriteLineCount[line];
+		if (count < 8) {
+			spriteLines[line][count] = sprite;
+			spriteLineCount[line] = count + 1;
+		} else {
+			spriteLineOverflow[line] = 1;
+		}
+	}
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Scanline handling
+// copies a plain memory OAM DMA source and rebuilds the scanline sprite lists in the same pass
+template<int spriteSize>
+static void CopyOAMDMA(nes_ppu& ppu, const unsigned char* src) {
+	ppu.syncRender();
+	memset(spriteLineCount, 0, sizeof(spriteLineCount));
+	memset(spriteLineOverflow, 0, sizeof(spriteLineOverflow));
+
+	for (int i = 0; i < 256; i += 4) {
+		ppu.oam[i] = src[i];
+		ppu.oam[i + 1] = src[i + 1];
+		ppu.oam[i + 2] = src[i + 2] & 0xE3;
+		ppu.oam[i + 3] = src[i + 3];
+		AddSpriteLines<spriteSize>(i, src[i]);
+	}
 
-inline void Rotate_2Bit(uint32& value) {
-#if TARGET_WINSIM
-	value = (value >> 2) | (value << 30);
-#else
-	asm volatile inline (
-		"rotr %[value]						\n\t"
-		"rotr %[value]						\n\t"
-		// outputs
-		: [value] "+r" (value)
-		// inputs
-		: "0" (value)
-		// clobbers
-		: "cc"
-	);
+	ppu.dirtyOAM = false;
+}
+
+// sprite pattern rows per plane byte, for normal [0] and horizontally flipped [1] sprites : the plane's pixels
+// interleaved 2 bits apart (bit 2k + 1 for pixel k from the left, pre-shifted for the palette OR), with the mask of
+// set pixels (bit k for pixel k) in bits 16-23
+static uint32 SpriteRowTable[2][256];
+
+#if TARGET_HOST
+// 64 bit variant, one byte per pixel from the left (2 if set)
+static unsigned long long SpriteRowTable64[2][256];
+#endif
+
+static void BuildSpriteRowTables() {
+	for (int flip = 0; flip < 2; flip++) {
+		for (int b = 0; b < 256; b++) {
+			uint32 row = 0;
+#if TARGET_HOST
+			unsigned long long row64 = 0;
+#endif
+			for (int k = 0; k < 8; k++) {
+				// pixel k from the left is bit 7 - k of the plane, or bit k when flipped
+				if (b & (flip ? (1 << k) : (0x80 >> k))) {
+					row |= (2 << (k * 2)) | (1 << (16 + k));
+#if TARGET_HOST
+					row64 |= 2ull << (k * 8);
+#endif
+				}
+			}
+
+			SpriteRowTable[flip][b] = row;
+#if TARGET_HOST
+			SpriteRowTable64[flip][b] = row64;
 #endif
+		}
+	}
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scanline handling
+
 inline void CopyOver16(uint8* srcBytes) {
-#if TARGET_WINSIM
+#if TARGET_WINSIM || TARGET_HOST
 	memcpy(srcBytes + 16, srcBytes, 16);
 #elif TARGET_PRIZM
 	asm (
@@ -87,7 +145,7 @@ void nes_ppu::midFrameScrollUpdate() {
 	if (actualScrollY >= 240) {
 		actualScrollY -= 256;
 	}
-	if (mainCPU.ppuClocks > mainCPU.clocks && mainCPU.ppuClocks - mainCPU.clocks >= 50 && !renderingDisabled) {
+	if (CLOCKS_BEFORE(mainCPU.clocks, mainCPU.eventClocks[EVENT_PPU]) && mainCPU.eventClocks[EVENT_PPU] - mainCPU.clocks >= 50 && !renderingDisabled) {
 		actualScrollY -= scanline - 2;
 	} else {
 		actualScrollY -= scanline - 1;
@@ -131,11 +189,11 @@ void nes_ppu::latchedReg(unsigned int addr) {
 
 		// suppress NMI on the exact clock cycle in the PPU it may be triggered (some games depend on this)
 		if (scanline == 243 && triggerNMI) {
-			if (mainCPU.clocks + 1 == mainCPU.ppuClocks) {
+			if (mainCPU.clocks + 1 == mainCPU.eventClocks[EVENT_PPU]) {
 				// one before, so donn't set the VBL as well
 				setVBL = false;
 				triggerNMI = false;
-			} else if (mainCPU.clocks == mainCPU.ppuClocks) {
+			} else if (mainCPU.clocks == mainCPU.eventClocks[EVENT_PPU]) {
 				triggerNMI = false;
 			}
 		}
@@ -188,18 +246,33 @@ void nes_ppu::latchedReg(unsigned int addr) {
 }
 
 void nes_ppu::writeReg(unsigned int regNum, unsigned char value) {
+	catchUp();
+
 	switch (regNum) {
 		case 0x00:	// PPUCTRL
+			// register changes between frames are caught by checkStaticFrame, but mid frame they need to render
+			if (value != PPUCTRL && scanline > 1 && scanline < 241) {
+				dirtyFrame = true;
+			}
 			if ((PPUCTRL & PPUCTRL_NMI) == 0 && (value & PPUCTRL_NMI) && (PPUSTATUS & PPUSTAT_NMI)) {
-				mainCPU.ppuNMI = true;
-				mainCPU.nextClocks = mainCPU.clocks + 1;	// force an NMI check AFTER the next instruction
+				mainCPU.schedule(EVENT_NMI, mainCPU.clocks + 1);	// force an NMI check AFTER the next instruction
+			}
+			if ((value ^ PPUCTRL) & PPUCTRL_SPRSIZE) {
+				// scanline sprite lists and the renderer depend on the sprite size
+				PPUCTRL = value;
+				dirtyOAM = true;
+				selectRenderScanline();
+			} else {
+				PPUCTRL = value;
 			}
-			PPUCTRL = value;
 			break;
 		case 0x01:	// PPUMASK
 			if (value != PPUMASK) {
-				if ((value ^ PPUMASK) & (PPUMASK_EMPHRED | PPUMASK_EMPHGREEN | PPUMASK_EMPHBLUE)) {
-					// emphasis bits changed, invalidate the palette
+				if (scanline > 1 && scanline < 241) {
+					dirtyFrame = true;
+				}
+				if ((value ^ PPUMASK) & (PPUMASK_EMPHRED | PPUMASK_EMPHGREEN | PPUMASK_EMPHBLUE | PPUMASK_GRAYSCALE)) {
+					// emphasis or grayscale bits changed, invalidate the palette
 					dirtyPalette = true;
 				}
 
@@ -221,11 +294,15 @@ void nes_ppu::writeReg(unsigned int regNum, unsigned char value) {
 			if (value != oam[OAMADDR]) {
 				oam[OAMADDR] = value;
 				dirtyOAM = true;
+				dirtyMemory();
 			}
 			OAMADDR++;	// writes to OAM data increment the OAM address
 			memoryMap[4] = oam[OAMADDR];
 			break;
 		case 0x05:  // SCROLLX/Y
+			if (scanline > 1 && scanline < 241) {
+				dirtyFrame = true;
+			}
 			if (writeToggle == 1) {
 				SCROLLY = value;
 			} else {
@@ -236,6 +313,9 @@ void nes_ppu::writeReg(unsigned int regNum, unsigned char value) {
 		case 0x06:  // ADDRHI/LO
 		{
 			// address writes always effect nametable and scroll bits as well, and will copy result mid-render
+			if (scanline > 1 && scanline < 241) {
+				dirtyFrame = true;
+			}
 
 			if (writeToggle == 1) {
 				// effects coarse scrollX, and scrollY, and applies write to Y scroll mid frame if need be
@@ -281,7 +361,20 @@ void nes_ppu::writeReg(unsigned int regNum, unsigned char value) {
 			}
 
 			// address will be incremented after the instruction due to latching
-			*resolveMemoryAddress(address, false) = value;
+			unsigned char* dest = resolveMemoryAddress(address, false);
+			if (*dest != value) {
+				// only changes need to invalidate what was rendered (pattern memory is rendered from directly)
+				if (address < 0x2000) {
+					syncRender();
+				}
+				*dest = value;
+				dirtyMemory();
+				if (address < 0x2000) {
+					invalidateDecodedCHR(dest, 1);
+				} else if (address < 0x3F00) {
+					dirtyNameTableRow(dest);
+				}
+			}
 
 #if TRACE_DEBUG
 			if (address - ((PPUCTRL & PPUCTRL_VRAMINC) ? 32 : 1) == ppuWriteBreakpoint) {
@@ -298,17 +391,52 @@ void nes_ppu::writeReg(unsigned int regNum, unsigned char value) {
 }
 
 void nes_ppu::oamDMA(unsigned int addr) {
-	// perform the oam DMA
-	for (int i = 0; i < 256; i++, addr++) {
-		oam[i] = mainCPU.read(addr);
-	}
+	uint8 changed = 0;
 
-	// force unused attribute bits low
-	for (int i = 2; i < 256; i += 4) {
-		oam[i] &= 0xE3;
+	const unsigned int page = addr >> 8;
+	if (page < 0x20 || page >= 0x60) {
+		// plain RAM / ROM page : no register side effects, so read through the page pointer directly
+		const unsigned char* src = mainCPU.getNonIOMem(addr);
+
+		// compare first (with the unused attribute bits forced low) so an unchanged OAM leaves deferred lines pending
+		for (int i = 0; i < 256; i += 4) {
+			changed |= (src[i] ^ oam[i]) | (src[i + 1] ^ oam[i + 1]) | ((src[i + 2] & 0xE3) ^ oam[i + 2]) | (src[i + 3] ^ oam[i + 3]);
+		}
+
+		if (changed) {
+			catchUp();
+
+			// sprite size changes dirty the lists again, so they can be built for the current size now
+			if (PPUCTRL & PPUCTRL_SPRSIZE) {
+				CopyOAMDMA<16>(*this, src);
+			} else {
+				CopyOAMDMA<8>(*this, src);
+			}
+			dirtyMemory();
+		}
+	} else {
+		// I/O page, read each byte so register reads are latched as usual
+		catchUp();
+
+		for (int i = 0; i < 256; i++, addr++) {
+			unsigned char value = mainCPU.read(addr);
+
+			// force unused attribute bits low
+			if ((i & 3) == 2) {
+				value &= 0xE3;
+			}
+
+			changed |= value ^ oam[i];
+			oam[i] = value;
+		}
+
+		// the scanline sprite lists only need rebuilding if something changed
+		if (changed) {
+			dirtyOAM = true;
+			dirtyMemory();
+		}
 	}
 
-	dirtyOAM = true;
 	mainCPU.clocks += 513 + (mainCPU.clocks & 1);
 }
 
@@ -333,17 +461,12 @@ void nes_ppu::fastSprite0(bool bValidBackground) {
 		tile = patternTable + (oam[1] << 4) + yCoord;
 	}
 
-	// interleave the bit planes and assign to char buffer (only unmapped pixels)
-	const uint8 tile0 = tile[0];
-	const uint8 tile8 = tile[8];
-	uint16 tileMask = (tile0 | tile8);
+	// mask of set pixels from the left
+	const uint32* rowTable = SpriteRowTable[(oam[2] & OAMATTR_HFLIP) ? 1 : 0];
+	uint16 tileMask = (rowTable[tile[0]] | rowTable[tile[8]]) >> 16;
 	unsigned int spriteX = oam[3];
 
 	if (tileMask && oam[3] != 255) {
-		if (!(oam[2] & OAMATTR_HFLIP)) {
-			tileMask = reverseByte(tileMask);
-		}
-
 		const uint8 LeftMask = (PPUMASK_SHOWLEFTBG | PPUMASK_SHOWLEFTOBJ);
 		if ((PPUMASK & LeftMask) != LeftMask) {
 			for (int x = spriteX, bit = 1; x < 8; x++, bit <<= 1) {
@@ -368,14 +491,21 @@ void nes_ppu::fastSprite0(bool bValidBackground) {
 }
 
 void nes_ppu::fastOAMLatchCheck() {
-	unsigned char* curObj = &oam[252];
+	if (dirtyOAM) {
+		resolveOAMExternal();
+	}
 
 	bool sprite16 = (PPUCTRL & PPUCTRL_SPRSIZE);
 	unsigned int patternOffset = ((!sprite16 && (PPUCTRL & PPUCTRL_OAMTABLE)) ? 0x1000 : 0x0000);
 
+	// only the sprites fetched for this line can latch
+	const uint8* lineSprites = spriteLines[scanline];
+	const unsigned int numLineSprites = spriteLineCount[scanline];
+
 	int furthestRight = -1;
 	int furthestLatch = 0;
-	for (int i = 0; i < 64; i++) {
+	for (unsigned int i = 0; i < numLineSprites; i++) {
+		const unsigned char* curObj = &oam[lineSprites[i]];
 		unsigned int yCoord = scanline - curObj[0] - 2;
 		if (yCoord == 0) {
 			// determine tile index
@@ -393,8 +523,6 @@ void nes_ppu::fastOAMLatchCheck() {
 				}
 			}
 		}
-
-		curObj -= 4;
 	}
 
 	if (furthestLatch) {
@@ -405,6 +533,57 @@ void nes_ppu::fastOAMLatchCheck() {
 // clocks per scanline formula: (341 / 3) + (scanline % 3 != 0 ? 1 : 0) for NTSC;
 char scanlineClocks[245];
 
+void nes_ppu::renderResolvedLine() {
+#if PPU_RENDER_THREAD
+	if (renderThreadActive) {
+		RenderThread_Scanline(true);
+		return;
+	}
+#endif
+
+	renderScanline(*this);
+
+	if (dirtyPalette) {
+		resolveWorkingPalette();
+	}
+
+	resolveScanline(SCROLLX & 15);
+}
+
+void nes_ppu::renderUnresolvedLine() {
+#if PPU_RENDER_THREAD
+	if (renderThreadActive) {
+		RenderThread_Scanline(false);
+		return;
+	}
+#endif
+
+	renderScanline(*this);
+}
+
+#if PPU_CATCH_UP
+void nes_ppu::renderCatchUp() {
+	TIME_SCOPE();
+
+	// cleared first since rendering may commit CHR banks, which catches up
+	const unsigned int first = catchUpFirst;
+	const unsigned int last = catchUpLast;
+	catchUpFirst = 0;
+
+	// interlaced frames only defer the lines of their field
+	const unsigned int curScanline = scanline;
+	for (scanline = first; scanline <= last; scanline++) {
+		if (!isOtherField()) {
+			renderResolvedLine();
+			catchUpLines++;
+		}
+	}
+	scanline = curScanline;
+
+	catchUpSpans++;
+}
+#endif
+
 void nes_ppu::step() {
 	TIME_SCOPE_NAMED("PPU Step");
 	
@@ -413,13 +592,13 @@ void nes_ppu::step() {
 
 	// cpu time for next scanline
 	DebugAssert(scanline < 245);
-	mainCPU.ppuClocks += scanlineClocks[scanline];
+	mainCPU.schedule(EVENT_PPU, mainCPU.eventClocks[EVENT_PPU] + scanlineClocks[scanline]);
     
 	/*
 		262 scanlines, we render 9-232 (middle 224 screen lines)
 
 		The idea is to render each scanline at the beginning of its line, and then
-		to get sprite 0 timing right use a different ppuClocks value / update function
+		to get sprite 0 timing right use a different EVENT_PPU time / update function
 	*/
 	if (scanline == 1) {
 		const int32 frameSkipValue = nesSettings.GetSetting(ST_FrameSkip);
@@ -440,10 +619,16 @@ void nes_ppu::step() {
 			case 4:
 			case 5:
 				skipFrame = (frameCounter % frameSkipValue) != 0;
+				break;
+			case 6: // interlaced
+				skipFrame = false;
+				break;
 		}
+		interlaceFrame = frameSkipValue == 6;
 
 		if (nesSettings.CheckCachedKey(NES_FASTFORWARD)) {
 			skipFrame = (frameCounter & 7) != 0;
+			interlaceFrame = false;
 		}
 
 		static bool bWasVolumeUp = false;
@@ -466,12 +651,19 @@ void nes_ppu::step() {
 			bWasVolumeDown = false;
 		}
 
-		// clear vblank and sprite 0 flag
-		SetPPUSTATUS(PPUSTATUS & ~(PPUSTAT_NMI | PPUSTAT_SPRITE0));		
+		// clear vblank, sprite 0 and sprite overflow flags
+		SetPPUSTATUS(PPUSTATUS & ~(PPUSTAT_NMI | PPUSTAT_SPRITE0 | PPUSTAT_OVERFLOW));		
 
 		// time to copy y scroll regs
 		copyYScrollRegs();
 
+		// frames with nothing changed since the last rendered frame are left on screen, which is free so they are
+		// never skipped
+		staticFrame = checkStaticFrame(skipFrame);
+		if (staticFrame) {
+			skipFrame = false;
+		}
+
 		if (nesCart.scanlineClock) {
 			nesCart.scanlineClock();
 		}
@@ -479,11 +671,12 @@ void nes_ppu::step() {
 		if (nesCart.bDirtyChrBanks) {
 			nesCart.CommitChrBanks();
 		}
+		checkSpriteOverflow();
 
 		// non-resolved but active scanline (may cause sprite 0 collision)
 		if (canSprite0Hit()) {
-			if (!skipFrame) {
-				renderScanline(*this);
+			if (!skipFrame && !staticFrame) {
+				renderUnresolvedLine();
 			} else {
 				fastSprite0(false);
 			}
@@ -501,16 +694,36 @@ void nes_ppu::step() {
 		if (nesCart.bDirtyChrBanks) {
 			nesCart.CommitChrBanks();
 		}
+		checkSpriteOverflow();
 
-		// rendered scanline
-		if (!skipFrame) {
-			renderScanline(*this);
+		// CHR pages that differ from the start of the last rendered frame are a mid frame change, which renders the
+		// rest of this frame and all of the next
+		if (chrPages[0] != lastRenderState.chrPages[0] || chrPages[1] != lastRenderState.chrPages[1]) {
+			dirtyFrame = true;
+		}
+		if (dirtyFrame) {
+			staticFrame = false;
+		}
 
-			if (dirtyPalette) {
-				resolveWorkingPalette();
+		// rendered scanline
+		if (!skipFrame && !staticFrame && !isOtherField()) {
+#if PPU_CATCH_UP
+			if (!nesCart.renderLatch && !lineAffectsEmulation()) {
+				// deferred until something changes or the visible frame ends
+				if (!catchUpFirst) {
+					catchUpFirst = scanline;
+				}
+				catchUpLast = scanline;
+			} else
+#endif
+			{
+				catchUp();
+				renderResolvedLine();
 			}
-
-			resolveScanline(SCROLLX & 15);
+		} else if (!skipFrame && !staticFrame && (nesCart.renderLatch || lineAffectsEmulation())) {
+			// lines of the other field are only rendered when emulation depends on them
+			catchUp();
+			renderUnresolvedLine();
 		} else if (canSprite0Hit()) {
 			fastSprite0(false);
 		}
@@ -519,14 +732,18 @@ void nes_ppu::step() {
 			nesCart.scanlineClock();
 		}
 	} else if (scanline < 241) {
+		// the resolved area is over, render any deferred lines
+		catchUp();
+
 		if (nesCart.bDirtyChrBanks) {
 			nesCart.CommitChrBanks();
 		}
+		checkSpriteOverflow();
 
 		// non-resolved scanline
 		if (canSprite0Hit()) {
-			if (!skipFrame) {
-				renderScanline(*this);
+			if (!skipFrame && !staticFrame) {
+				renderUnresolvedLine();
 			} else {
 				fastSprite0(false);
 			}
@@ -539,9 +756,13 @@ void nes_ppu::step() {
 		// good time to reset scroll
 		scrollY = 0;
 
-		// blank scanline area, trigger NMI next scanline
-		triggerNMI = (mainCPU.clocks > 140000);
-		setVBL = (mainCPU.clocks > 30000);
+		// blank scanline area, trigger NMI next scanline (neither occur in the first frames after reset, latched once past
+		// since the master clock may wrap)
+		if (!startedUp) {
+			startedUp = mainCPU.clocks > 140000;
+		}
+		triggerNMI = startedUp;
+		setVBL = startedUp || mainCPU.clocks > 30000;
 	} else if (scanline == 242) {
 		TIME_SCOPE_NAMED(lastScanline);
 
@@ -549,7 +770,8 @@ void nes_ppu::step() {
 			SetPPUSTATUS(PPUSTATUS | PPUSTAT_NMI);
 		}
 		if ((PPUCTRL & PPUCTRL_NMI) && triggerNMI) {
-			mainCPU.ppuNMI = true;
+			// NMI after the next instruction or so
+			mainCPU.schedule(EVENT_NMI, mainCPU.clocks + 7);
 		}
 
 		// update background color if we are in that BG mode
@@ -558,6 +780,7 @@ void nes_ppu::step() {
 			if (curColor != currentBGColor) {
 				currentBGColor = curColor;
 				nesSettings.cachedTime = -1; // if we are rendering a clock, it needs to be invalidated
+				syncRender();
 				renderBGOverscan();
 			}
 		}
@@ -569,6 +792,7 @@ void nes_ppu::step() {
 			int curTime = hour * 256 + minute;
 			if (curTime != nesSettings.cachedTime) {
 				nesSettings.cachedTime = curTime;
+				syncRender();
 				renderClock();
 			}
 		}
@@ -591,13 +815,26 @@ void nes_ppu::step() {
 				totalFrames /= 4; // calculated FPS
 				if (totalFrames < 1) totalFrames = 1;
 				if (totalFrames > 240) totalFrames = 240;
+				syncRender();
 				renderFPS(totalFrames);
 				frameBuckets[curBucket] = 0;
 			}
 			lastTicks = ticks % 64;
 		}
 
-		finishFrame(skipFrame);
+#if PPU_RENDER_THREAD
+		if (renderThreadActive) {
+			RenderThread_FinishFrame(skipFrame);
+		} else
+#endif
+		{
+			if (!skipFrame) {
+				lastFrameLinesSkipped = linesSkipped;
+				linesSkipped = 0;
+			}
+
+			finishFrame(skipFrame);
+		}
 
 		ScopeTimer::ReportFrame();
 
@@ -633,18 +870,16 @@ void nes_ppu::step() {
 
 		if (nesSettings.CheckCachedKey(NES_LOADSTATE)) // F4 in simulator, 'L' on device
 		{
+			syncRender();
 			nesCart.LoadState();
 		}
-		
-		// good time to synchronize cpu clock if we are getting too high (to avoid wraparound at 30 min of play)
-		mainCPU.syncClocks();
 
 	} else if (scanline == 243) {
 		// frame is over, don't run until scanline 262, so add 18 scanlines worth (2047 extra clocks!)
 		if (nesCart.isPAL == 0) {
-			mainCPU.ppuClocks += 18 * (341 / 3) + 12;
+			mainCPU.schedule(EVENT_PPU, mainCPU.eventClocks[EVENT_PPU] + 18 * (341 / 3) + 12);
 		} else {
-			mainCPU.ppuClocks += (68 * 1705) / 16;
+			mainCPU.schedule(EVENT_PPU, mainCPU.eventClocks[EVENT_PPU] + (68 * 1705) / 16);
 		}
 
 	} else {
@@ -653,7 +888,7 @@ void nes_ppu::step() {
 
 		// frame timing .. total ppu frame should be every 29780.5 ppu clocks
 		if (nesCart.isPAL == 0) {
-			mainCPU.ppuClocks -= 1;
+			mainCPU.schedule(EVENT_PPU, mainCPU.eventClocks[EVENT_PPU] - 1);
 		}
 
 		// one scanline "ahead"
@@ -672,43 +907,6 @@ void nes_ppu::step() {
 
 // 16 byte overlay for bit plane -> 8 bit palette plane
 
-// Credit to Stanford bit twiddling hacks
-static const unsigned short MortonTable[256] = 
-{
-  0x0000, 0x0001, 0x0004, 0x0005, 0x0010, 0x0011, 0x0014, 0x0015, 
-  0x0040, 0x0041, 0x0044, 0x0045, 0x0050, 0x0051, 0x0054, 0x0055, 
-  0x0100, 0x0101, 0x0104, 0x0105, 0x0110, 0x0111, 0x0114, 0x0115, 
-  0x0140, 0x0141, 0x0144, 0x0145, 0x0150, 0x0151, 0x0154, 0x0155, 
-  0x0400, 0x0401, 0x0404, 0x0405, 0x0410, 0x0411, 0x0414, 0x0415, 
-  0x0440, 0x0441, 0x0444, 0x0445, 0x0450, 0x0451, 0x0454, 0x0455, 
-  0x0500, 0x0501, 0x0504, 0x0505, 0x0510, 0x0511, 0x0514, 0x0515, 
-  0x0540, 0x0541, 0x0544, 0x0545, 0x0550, 0x0551, 0x0554, 0x0555, 
-  0x1000, 0x1001, 0x1004, 0x1005, 0x1010, 0x1011, 0x1014, 0x1015, 
-  0x1040, 0x1041, 0x1044, 0x1045, 0x1050, 0x1051, 0x1054, 0x1055, 
-  0x1100, 0x1101, 0x1104, 0x1105, 0x1110, 0x1111, 0x1114, 0x1115, 
-  0x1140, 0x1141, 0x1144, 0x1145, 0x1150, 0x1151, 0x1154, 0x1155, 
-  0x1400, 0x1401, 0x1404, 0x1405, 0x1410, 0x1411, 0x1414, 0x1415, 
-  0x1440, 0x1441, 0x1444, 0x1445, 0x1450, 0x1451, 0x1454, 0x1455, 
-  0x1500, 0x1501, 0x1504, 0x1505, 0x1510, 0x1511, 0x1514, 0x1515, 
-  0x1540, 0x1541, 0x1544, 0x1545, 0x1550, 0x1551, 0x1554, 0x1555, 
-  0x4000, 0x4001, 0x4004, 0x4005, 0x4010, 0x4011, 0x4014, 0x4015, 
-  0x4040, 0x4041, 0x4044, 0x4045, 0x4050, 0x4051, 0x4054, 0x4055, 
-  0x4100, 0x4101, 0x4104, 0x4105, 0x4110, 0x4111, 0x4114, 0x4115, 
-  0x4140, 0x4141, 0x4144, 0x4145, 0x4150, 0x4151, 0x4154, 0x4155, 
-  0x4400, 0x4401, 0x4404, 0x4405, 0x4410, 0x4411, 0x4414, 0x4415, 
-  0x4440, 0x4441, 0x4444, 0x4445, 0x4450, 0x4451, 0x4454, 0x4455, 
-  0x4500, 0x4501, 0x4504, 0x4505, 0x4510, 0x4511, 0x4514, 0x4515, 
-  0x4540, 0x4541, 0x4544, 0x4545, 0x4550, 0x4551, 0x4554, 0x4555, 
-  0x5000, 0x5001, 0x5004, 0x5005, 0x5010, 0x5011, 0x5014, 0x5015, 
-  0x5040, 0x5041, 0x5044, 0x5045, 0x5050, 0x5051, 0x5054, 0x5055, 
-  0x5100, 0x5101, 0x5104, 0x5105, 0x5110, 0x5111, 0x5114, 0x5115, 
-  0x5140, 0x5141, 0x5144, 0x5145, 0x5150, 0x5151, 0x5154, 0x5155, 
-  0x5400, 0x5401, 0x5404, 0x5405, 0x5410, 0x5411, 0x5414, 0x5415, 
-  0x5440, 0x5441, 0x5444, 0x5445, 0x5450, 0x5451, 0x5454, 0x5455, 
-  0x5500, 0x5501, 0x5504, 0x5505, 0x5510, 0x5511, 0x5514, 0x5515, 
-  0x5540, 0x5541, 0x5544, 0x5545, 0x5550, 0x5551, 0x5554, 0x5555
-};
-
 // table of 8 byte wide bit overlays per all possible 256 byte combinations
 const uint8 OverlayTable[8 * 256] = {
 	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,2,0,0,0,0,0,0,2,0,0,0,0,0,0,0,2,2,0,0,0,0,0,2,0,0,0,0,0,0,0,2,0,2,0,0,0,0,0,2,2,0,0,0,0,0,0,2,2,2,
@@ -745,10 +943,10 @@ const uint8 OverlayTable[8 * 256] = {
 	2,2,2,2,2,0,0,0,2,2,2,2,2,0,0,2,2,2,2,2,2,0,2,0,2,2,2,2,2,0,2,2,2,2,2,2,2,2,0,0,2,2,2,2,2,2,0,2,2,2,2,2,2,2,2,0,2,2,2,2,2,2,2,2,
 };
 
-#if TARGET_WINSIM
+#if TARGET_WINSIM || TARGET_HOST
 // super fast blitting method!
 inline void RenderToScanline(unsigned char*patternTable, int chr, uint32 unrolledPalette, uint8* buffer) {
-	DebugAssert((uint32(buffer) & 3) == 0); // long alignment required in SH4
+	DebugAssert((size_t(buffer) & 3) == 0); // long alignment required in SH4
 
 	unsigned int* bitPlane1 = (unsigned int*) &OverlayTable[patternTable[chr] * 8];
 	unsigned int* bitPlane2 = (unsigned int*) &OverlayTable[patternTable[chr + 8] * 8];
@@ -762,31 +960,265 @@ extern "C" {
 }
 #endif
 
-// mask of which sprites to check per scanline (bit 0 = sprites 56-63, bit 1 = sprites 48-55, and so on)
-uint8 fetchMask[272];
-template<int spriteSize>
-void nes_ppu::resolveOAM() {
-	// rebuild the fetch mask
-	memset(fetchMask, 0, 240);
+// a 4 KB pattern page decoded for the background renderer, keyed by the page memory. Tiles are decoded the first time
+// they are rendered, so switching pages only costs the tiles actually used
+struct nes_decoded_chr_page {
+	const unsigned char* source;	// page memory decoded (NULL if unused)
+	unsigned int lastTaken;			// decodedCHRTakes when last taken, the least recent page is replaced
+	uint32 validTiles[8];			// tiles decoded since the page was taken or its memory last changed
+	uint8* tiles;					// 256 tiles of DECODED_CHR_TILE_SIZE bytes
+};
 
-	unsigned char* curObj = &oam[252];
-	const int scanlineOffset = 2;
+static nes_decoded_chr_page decodedCHRPages[NUM_DECODED_CHR_PAGES];
+static int numDecodedCHRPages = 0;
+static unsigned int decodedCHRTakes = 0;
 
-	for (int b = 0; b < 8; b++) {
-		uint8 bitMask = (1 << b);
-		for (int i = 0; i < 8; i++, curObj -= 4) {
-			unsigned int line = curObj[0] + scanlineOffset;
-			if (line <= 242) {
-				for (int x = 0; x < spriteSize; x++, line++) {
-					fetchMask[line] |= bitMask;
-				}
-			}
+void nes_ppu::allocateDecodedCHR() {
+	DebugAssert(numDecodedCHRPages == 0);
+
+	// the reserve is held while allocating so the pages always leave that much heap free while in game
+	void* reserve = malloc(DECODED_HEAP_RESERVE);
+	if (reserve == NULL)
+		return;
+
+	for (int i = 0; i < NUM_DECODED_CHR_PAGES; i++) {
+		uint8* tiles = (uint8*) malloc(256 * DECODED_CHR_TILE_SIZE);
+		if (tiles) {
+			nes_decoded_chr_page& page = decodedCHRPages[numDecodedCHRPages++];
+			page.source = NULL;
+			page.lastTaken = 0;
+			page.tiles = tiles;
+		} else {
+			break;
+		}
+	}
+
+	free(reserve);
+}
+
+void nes_ppu::freeDecodedCHR() {
+	for (int i = 0; i < numDecodedCHRPages; i++) {
+		free(decodedCHRPages[i].tiles);
+		decodedCHRPages[i].tiles = NULL;
+	}
+	numDecodedCHRPages = 0;
+}
+
+void nes_ppu::invalidateDecodedCHR(const unsigned char* memory, unsigned int size) {
+	syncRender();
+	bgRowCacheVersion++;
+
+	for (int i = 0; i < numDecodedCHRPages; i++) {
+		nes_decoded_chr_page& page = decodedCHRPages[i];
+		if (page.source == NULL || memory >= page.source + 0x1000 || memory + size <= page.source)
+			continue;
+
+		const unsigned int first = memory > page.source ? (memory - page.source) >> 4 : 0;
+		const unsigned int last = memory + size < page.source + 0x1000 ? (memory + size - 1 - page.source) >> 4 : 255;
+		for (unsigned int tile = first; tile <= last; tile++) {
+			page.validTiles[tile >> 5] &= ~(1u << (tile & 31));
+		}
+	}
+}
+
+// returns the decoded page for the given pattern page (replacing the least recently taken one), or NULL if there are none
+static nes_decoded_chr_page* TakeDecodedCHRPage(const unsigned char* source) {
+	if (numDecodedCHRPages == 0)
+		return NULL;
+
+	decodedCHRTakes++;
+
+	nes_decoded_chr_page* page = &decodedCHRPages[0];
+	for (int i = 0; i < numDecodedCHRPages; i++) {
+		if (decodedCHRPages[i].source == source) {
+			page = &decodedCHRPages[i];
+			page->lastTaken = decodedCHRTakes;
+			return page;
+		}
+		if (decodedCHRPages[i].lastTaken < page->lastTaken) {
+			page = &decodedCHRPages[i];
 		}
 	}
 
+	page->source = source;
+	page->lastTaken = decodedCHRTakes;
+	memset(page->validTiles, 0, sizeof(page->validTiles));
+	return page;
+}
+
+// returns the given row of a decoded tile, decoding the tile first if needed
+static FORCE_INLINE const uint32* DecodedCHRRow(nes_decoded_chr_page* page, unsigned int chr, unsigned int chrOffset) {
+	uint32* tile = (uint32*) &page->tiles[chr * DECODED_CHR_TILE_SIZE];
+
+	if ((page->validTiles[chr >> 5] & (1u << (chr & 31))) == 0) {
+#if TARGET_HOST
+		hostKernels.decodeTiles(page->source + (chr << 4), (uint8*) tile, 1);
+#else
+		const unsigned char* planes = page->source + (chr << 4);
+		for (int row = 0; row < 8; row++) {
+			const uint32* bitPlane1 = (const uint32*) &OverlayTable[planes[row] * 8];
+			const uint32* bitPlane2 = (const uint32*) &OverlayTable[planes[row + 8] * 8];
+			tile[row * 2 + 0] = bitPlane1[0] | (bitPlane2[0] << 1);
+			tile[row * 2 + 1] = bitPlane1[1] | (bitPlane2[1] << 1);
+		}
+#endif
+		page->validTiles[chr >> 5] |= 1u << (chr & 31);
+	}
+
+	return tile + chrOffset * 2;
+}
+
+// renders a row of 8 background pixels, a copy of the decoded row plus the palette OR when there is a decoded page
+static FORCE_INLINE void RenderTileRow(nes_decoded_chr_page* decodedPage, unsigned char* patternTable, unsigned int chr,
+	unsigned int chrOffset, uint32 unrolledPalette, uint8* buffer) {
+	if (decodedPage) {
+		const uint32* row = DecodedCHRRow(decodedPage, chr, chrOffset);
+		uint32* scanline = (uint32*) buffer;
+		scanline[0] = unrolledPalette | row[0];
+		scanline[1] = unrolledPalette | row[1];
+	} else {
+		RenderToScanline(patternTable, chr << 4, unrolledPalette, buffer);
+	}
+}
+
+// states of a cached background row : keyed this frame, key held since the last render (store the pixels), pixels stored
+enum {
+	BG_ROW_KEYED,
+	BG_ROW_HELD,
+	BG_ROW_STORED
+};
+
+// rendered background of a scanline (before sprites) along with everything it was rendered from
+struct nes_bg_row {
+	const uint8* nameRows[2];	// nametable rows rendered (the same row twice unless rendering from two nametables)
+	const uint8* chrPage;		// background pattern page
+	unsigned int version;		// ppu.bgRowCacheVersion
+	uint16 rowVersions[2];		// ppu.nameTableRowVersion of each nametable row
+	uint8 chrOffset;			// fine Y
+	uint8 tileX;				// first (even) tile rendered, the fine X scroll is applied during resolve
+	uint8 state;				// BG_ROW_KEYED, BG_ROW_HELD or BG_ROW_STORED
+
+	uint8 pixels[16 * 17] ALIGN(4);
+};
+
+static nes_bg_row* bgRowCache = NULL;
+
+void nes_ppu::allocateBGRowCache() {
+	DebugAssert(bgRowCache == NULL);
+
+	// the reserve is held while allocating so the cache always leaves that much heap free while in game
+	void* reserve = malloc(DECODED_HEAP_RESERVE);
+	if (reserve == NULL)
+		return;
+
+	bgRowCache = (nes_bg_row*) malloc(sizeof(nes_bg_row) * NUM_BG_ROW_CACHE_LINES);
+	if (bgRowCache) {
+		memset(bgRowCache, 0, sizeof(nes_bg_row) * NUM_BG_ROW_CACHE_LINES);
+	}
+
+	free(reserve);
+}
+
+void nes_ppu::freeBGRowCache() {
+	syncRender();
+	free(bgRowCache);
+	bgRowCache = NULL;
+}
+
+void nes_ppu::dirtyNameTableRow(const unsigned char* dest) {
+	const unsigned int offset = dest - nameTables[0].table;
+	const unsigned int table = offset >> 10;
+	const unsigned int index = offset & 0x3FF;
+
+	if (index < 960) {
+		nameTableRowVersion[table][index >> 5]++;
+	} else {
+		// each attribute byte covers 4 rows
+		unsigned int row = ((index - 960) >> 3) * 4;
+		for (int i = 0; i < 4 && row < 30; i++, row++) {
+			nameTableRowVersion[table][row]++;
+		}
+	}
+}
+
+static FORCE_INLINE uint16 NameTableRowVersion(nes_ppu& ppu, const uint8* nameRow) {
+	const unsigned int offset = nameRow - ppu.nameTables[0].table;
+	return ppu.nameTableRowVersion[offset >> 10][(offset & 0x3FF) >> 5];
+}
+
+// copies the cached background for the current scanline if it was rendered from the same inputs. Otherwise the row
+// is keyed to the current inputs, and StoreBGRow keeps the rendered pixels only once the key has held since the last
+// render, so scrolling rows cost a key compare rather than a copy
+static bool FetchBGRow(nes_ppu& ppu, const uint8* const* nameRows, unsigned int chrOffset, unsigned int tileX) {
+	if (bgRowCache == NULL)
+		return false;
+
+	nes_bg_row& row = bgRowCache[ppu.scanline - 1];
+	const uint8* chrPage = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4];
+	const uint16 rowVersion0 = NameTableRowVersion(ppu, nameRows[0]);
+	const uint16 rowVersion1 = NameTableRowVersion(ppu, nameRows[1]);
+
+	if (row.nameRows[0] == nameRows[0] && row.nameRows[1] == nameRows[1] && row.chrPage == chrPage &&
+		row.version == ppu.bgRowCacheVersion && row.rowVersions[0] == rowVersion0 && row.rowVersions[1] == rowVersion1 &&
+		row.chrOffset == chrOffset && row.tileX == tileX) {
+		if (row.state == BG_ROW_STORED) {
+			memcpy(ppu.scanlineBuffer, row.pixels, sizeof(row.pixels));
+			return true;
+		}
+		row.state = BG_ROW_HELD;
+		return false;
+	}
+
+	row.nameRows[0] = nameRows[0];
+	row.nameRows[1] = nameRows[1];
+	row.chrPage = chrPage;
+	row.version = ppu.bgRowCacheVersion;
+	row.rowVersions[0] = rowVersion0;
+	row.rowVersions[1] = rowVersion1;
+	row.chrOffset = chrOffset;
+	row.tileX = tileX;
+	row.state = BG_ROW_KEYED;
+	return false;
+}
+
+// keeps the rendered background for the current scanline if its key held since the last render
+static FORCE_INLINE void StoreBGRow(nes_ppu& ppu) {
+	if (bgRowCache == NULL)
+		return;
+
+	nes_bg_row& row = bgRowCache[ppu.scanline - 1];
+	if (row.state == BG_ROW_HELD) {
+		memcpy(row.pixels, ppu.scanlineBuffer, sizeof(row.pixels));
+		row.state = BG_ROW_STORED;
+	}
+}
+
+template<int spriteSize>
+void nes_ppu::resolveOAM() {
+	// rebuild the scanline sprite lists
+	syncRender();
+	memset(spriteLineCount, 0, sizeof(spriteLineCount));
+	memset(spriteLineOverflow, 0, sizeof(spriteLineOverflow));
+
+	for (int i = 0; i < 256; i += 4) {
+		AddSpriteLines<spriteSize>(i, oam[i]);
+	}
+
 	dirtyOAM = false;
 }
 
+void nes_ppu::checkSpriteOverflow() {
+	if ((PPUSTATUS & PPUSTAT_OVERFLOW) == 0 && (PPUMASK & (PPUMASK_SHOWOBJ | PPUMASK_SHOWBG))) {
+		if (dirtyOAM) {
+			resolveOAMExternal();
+		}
+
+		if (spriteLineOverflow[scanline]) {
+			SetPPUSTATUS(PPUSTATUS | PPUSTAT_OVERFLOW);
+		}
+	}
+}
+
 #define PRIORITY_PIXEL 0x40
 template<bool sprite16,int spriteSize>
 void static renderOAM(nes_ppu& ppu) {
@@ -807,10 +1239,9 @@ void static renderOAM(nes_ppu& ppu) {
 		}
 	}
 
-	if ((ppu.PPUMASK & PPUMASK_SHOWOBJ) && fetchMask[ppu.scanline]) {
+	const int numLineSprites = spriteLineCount[ppu.scanline];
+	if ((ppu.PPUMASK & PPUMASK_SHOWOBJ) && numLineSprites) {
 		// render objects to separate buffer
-		int numSprites = 0;
-		unsigned char* curObj = &ppu.oam[252];
 		unsigned int patternOffset = ((!sprite16 && (ppu.PPUCTRL & PPUCTRL_OAMTABLE)) ? 1 : 0);
 		unsigned char* patternTable = ppu.chrPages[patternOffset];
 		static uint8 spriteMask[33] = { 0 };
@@ -819,114 +1250,109 @@ void static renderOAM(nes_ppu& ppu) {
 		int scanlineOffset = ppu.scanline - 2;
 		bool bHadBGPriority = false;
 
-		// mask out 8 at a time
-		for (int b = fetchMask[ppu.scanline]; b; b = b >> 1) {
-			if (!(b & 1)) {
-				curObj -= 32;
-				continue;
-			}
+		// in reverse OAM order so lower sprites are drawn over higher ones
+		const uint8* lineSprites = spriteLines[ppu.scanline];
+		for (int s = numLineSprites - 1; s >= 0; s--) {
+			const unsigned char* curObj = &ppu.oam[lineSprites[s]];
+			unsigned int yCoord = scanlineOffset - curObj[0];
+			DebugAssert(yCoord < spriteSize);
+			if (curObj[2] & OAMATTR_VFLIP) yCoord = (spriteSize - 1) - yCoord;
 
-			for (int i = 0; i < 8; i++, curObj -= 4) {
-				unsigned int yCoord = scanlineOffset - curObj[0];
-				if (yCoord < spriteSize) {
-					numSprites++;
+			// determine tile index
+			unsigned char* tile;
+			if (sprite16) {
+				tile = ppu.chrPages[curObj[1] & 1] + ((curObj[1] & 0xFE) << 4) + ((yCoord & 8) << 1) + (yCoord & 7);
+			} else {
+				tile = patternTable + (curObj[1] << 4) + yCoord;
+			}
 
-					if (curObj[2] & OAMATTR_VFLIP) yCoord = (spriteSize - 1) - yCoord;
+			unsigned int x = curObj[3];
 
-					// determine tile index
-					unsigned char* tile;
-					if (sprite16) {
-						tile = ppu.chrPages[curObj[1] & 1] + ((curObj[1] & 0xFE) << 4) + ((yCoord & 8) << 1) + (yCoord & 7);
-					} else {
-						tile = patternTable + (curObj[1] << 4) + yCoord;
-					}
-
-					unsigned int x = curObj[3];
-
-					// interleave the bit planes and assign to char buffer (only unmapped pixels)
-					const uint8 tile0 = tile[0];
-					const uint8 tile8 = tile[8];
-					uint16 tileMask = (tile0 | tile8);
-					unsigned int bitPlane = (MortonTable[tile0] | (MortonTable[tile8] << 1)) << 1;
-					unsigned int palette = (((curObj[2] & 3) << 2) + (curObj[2] & OAMATTR_PRIORITY) + 16) << 1;
-					unsigned char* buffer = oamScanlineBuffer + x;
-					if (curObj[2] & OAMATTR_PRIORITY) {
-						bHadBGPriority = true;
-					}
+			// decode the row pre-flipped, so pixels always go left to right (only set pixels are written)
+			const unsigned int flip = (curObj[2] & OAMATTR_HFLIP) ? 1 : 0;
+			unsigned int palette = (((curObj[2] & 3) << 2) + (curObj[2] & OAMATTR_PRIORITY) + 16) << 1;
+			unsigned char* buffer = oamScanlineBuffer + x;
+			if (curObj[2] & OAMATTR_PRIORITY) {
+				bHadBGPriority = true;
+			}
 
-					if (curObj[2] & OAMATTR_HFLIP) {
-											if (bitPlane & 6) buffer[0] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[1] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[2] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[3] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[4] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[5] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[6] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[7] = palette | (bitPlane & 6);
-					} else {
-						tileMask = reverseByte(tileMask);
-											if (bitPlane & 6) buffer[7] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[6] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[5] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[4] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[3] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[2] = palette | (bitPlane & 6); 
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[1] = palette | (bitPlane & 6);
-						bitPlane >>= 2;		if (bitPlane & 6) buffer[0] = palette | (bitPlane & 6);
-					}
+#if TARGET_HOST
+			// all 8 pixels at once, bytes with a set pixel replaced by palette | pixel
+			const unsigned long long plane0 = SpriteRowTable64[flip][tile[0]];
+			const unsigned long long plane8 = SpriteRowTable64[flip][tile[8]];
+			const unsigned long long setPixels = (plane0 | plane8) >> 1;
+			const unsigned long long setBytes = setPixels * 0xFF;
+			unsigned long long pixels;
+			memcpy(&pixels, buffer, 8);
+			pixels = (pixels & ~setBytes) | ((plane0 | (plane8 << 1) | (palette * 0x0101010101010101ull)) & setBytes);
+			memcpy(buffer, &pixels, 8);
+
+			// gathers the low bit of each byte into bit k for byte k
+			uint16 tileMask = (uint16) ((setPixels * 0x0102040810204080ull) >> 56);
+#else
+			const uint32 row0 = SpriteRowTable[flip][tile[0]];
+			const uint32 row8 = SpriteRowTable[flip][tile[8]];
+			uint16 tileMask = (row0 | row8) >> 16;
+			unsigned int bitPlane = (row0 & 0xFFFF) | ((row8 & 0xFFFF) << 1);
+									if (bitPlane & 6) buffer[0] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[1] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[2] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[3] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[4] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[5] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[6] = palette | (bitPlane & 6);
+			bitPlane >>= 2;		if (bitPlane & 6) buffer[7] = palette | (bitPlane & 6);
+#endif
 
-					int mask = x >> 3;
-					tileMask = tileMask << (x & 7);
-					spriteMask[mask] |= tileMask & 0xFF;
-					if (mask < minSpriteMask) minSpriteMask = mask;
-					if (mask > maxSpriteMask) maxSpriteMask = mask;
-					mask = (x+7) >> 3;
-					spriteMask[mask] |= tileMask >> 8;
-					if (mask < minSpriteMask) minSpriteMask = mask;
-					if (mask > maxSpriteMask) maxSpriteMask = mask;
-				}
-			}
+			int mask = x >> 3;
+			tileMask = tileMask << (x & 7);
+			spriteMask[mask] |= tileMask & 0xFF;
+			if (mask < minSpriteMask) minSpriteMask = mask;
+			if (mask > maxSpriteMask) maxSpriteMask = mask;
+			mask = (x+7) >> 3;
+			spriteMask[mask] |= tileMask >> 8;
+			if (mask < minSpriteMask) minSpriteMask = mask;
+			if (mask > maxSpriteMask) maxSpriteMask = mask;
 		}
 
-		if (numSprites) {
-			// mask left 8 pixels
-			if ((ppu.PPUMASK & PPUMASK_SHOWLEFTOBJ) == 0) {
-				for (int i = 0; i < 8; i++) {
-					oamScanlineBuffer[i] = 0;
-				}
+		// mask left 8 pixels
+		if ((ppu.PPUMASK & PPUMASK_SHOWLEFTOBJ) == 0) {
+			for (int i = 0; i < 8; i++) {
+				oamScanlineBuffer[i] = 0;
 			}
+		}
 
-			// resolve objects
-			if (maxSpriteMask > 31) maxSpriteMask = 31;
-			unsigned char* targetPixelBase = &ppu.scanlineBuffer[baseX];
-			for (int sprite = minSpriteMask; sprite <= maxSpriteMask; sprite++) {
-				if (spriteMask[sprite]) {
-					unsigned char* targetPixel = targetPixelBase + sprite * 8;
-					unsigned char* oamPixel = &oamScanlineBuffer[sprite *8];
-					if (bHadBGPriority) {
-						for (int b = spriteMask[sprite]; b; b >>= 1, oamPixel++, targetPixel++) {
-							if (b & 1) {
-								if ((*oamPixel & PRIORITY_PIXEL) == 0 || (*targetPixel & 6) == 0) {
-									*targetPixel = (*oamPixel & (PRIORITY_PIXEL - 1));
-								}
-								*oamPixel = 0;
-							}
-						}
-					} else {
-						for (int b = spriteMask[sprite]; b; b >>= 1, oamPixel++, targetPixel++) {
-							if (b & 1) {
+		// resolve objects
+		if (maxSpriteMask > 31) maxSpriteMask = 31;
+		unsigned char* targetPixelBase = &ppu.scanlineBuffer[baseX];
+		for (int sprite = minSpriteMask; sprite <= maxSpriteMask; sprite++) {
+			if (spriteMask[sprite]) {
+				unsigned char* targetPixel = targetPixelBase + sprite * 8;
+				unsigned char* oamPixel = &oamScanlineBuffer[sprite *8];
+				if (bHadBGPriority) {
+					for (int b = spriteMask[sprite]; b; b >>= 1, oamPixel++, targetPixel++) {
+						if (b & 1) {
+							if ((*oamPixel & PRIORITY_PIXEL) == 0 || (*targetPixel & 6) == 0) {
 								*targetPixel = (*oamPixel & (PRIORITY_PIXEL - 1));
-								*oamPixel = 0;
 							}
+							*oamPixel = 0;
+						}
+					}
+				} else {
+					for (int b = spriteMask[sprite]; b; b >>= 1, oamPixel++, targetPixel++) {
+						if (b & 1) {
+							*targetPixel = (*oamPixel & (PRIORITY_PIXEL - 1));
+							*oamPixel = 0;
 						}
 					}
-					spriteMask[sprite] = 0;
 				}
+				spriteMask[sprite] = 0;
 			}
 		}
 	}
 }
 
+template<int spriteSize>
 void nes_ppu::doOAMRender() {
 	TIME_SCOPE();
 
@@ -934,11 +1360,7 @@ void nes_ppu::doOAMRender() {
 		fastSprite0(true);
 	}
 
-	if ((PPUCTRL & PPUCTRL_SPRSIZE) == 0) {
-		renderOAM<false, 8>(*this);
-	} else {
-		renderOAM<true, 16>(*this);
-	}
+	renderOAM<spriteSize == 16, spriteSize>(*this);
 }
 
 void nes_ppu::resolveOAMExternal() {
@@ -949,273 +1371,147 @@ void nes_ppu::resolveOAMExternal() {
 	}
 }
 
-inline void UnrollPalette(uint32& palette) {
-	// put palette in every 4 bytes (* 2 to account for offset into word sized color table during resolve)
-	palette <<= 1;
-	palette = palette | (palette << 8);
-	palette = palette | (palette << 16);
-}
-
-void nes_ppu::renderScanline_SingleMirror(nes_ppu& ppu) {
-	TIME_SCOPE_NAMED(scanline_single);
+bool nes_ppu::lineUnchanged(int scrollOffset) {
+	uint32* lineHash = resolvedLineHash[scanline - 1];
 
-	DebugAssert(ppu.scanline >= 1 && ppu.scanline <= 240);
-	DebugAssert(nesCart.renderLatch == NULL);
-
-	int line = ppu.scanline - 1;
-	if (ppu.scrollY < 240) {
-		line += ppu.scrollY;
-	} else {
-		// "negative scroll" which we'll just skip the top lines for
-		line += ppu.scrollY - 256;
+	// a line scrolled since it was last resolved will almost always differ, so resolve it without paying for the hash
+	const uint32 scroll = SCROLLX | ((PPUCTRL & (PPUCTRL_FLIPXTBL | PPUCTRL_FLIPYTBL)) << 8) | ((uint32) scrollY << 16);
+	if (resolvedLineScroll[scanline - 1] != scroll) {
+		resolvedLineScroll[scanline - 1] = scroll;
+		lineHash[0] = 0xFFFFFFFF;
+		lineHash[1] = 0xFFFFFFFF;
+		return false;
 	}
 
-	if ((ppu.PPUMASK & PPUMASK_SHOWBG) && line >= 0) {
-		int tileLine = line >> 3;
-
-		// determine base addresses
-		unsigned char* nameTable;
-		unsigned char* attr;
-		unsigned int chrOffset = (line & 7);
-		unsigned char* patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-
-		if (tileLine >= 30) {
-			tileLine -= 30;
-		}
-		
-		if (ppu.mirror == nes_mirror_type::MT_SINGLE) {
-			nameTable = &ppu.nameTables[0].table[tileLine << 5];
-			attr = &ppu.nameTables[0].attr[(tileLine >> 2) << 3];
-		} else {
-			DebugAssert(ppu.mirror == nes_mirror_type::MT_SINGLE_UPPER);
-			nameTable = &ppu.nameTables[1].table[tileLine << 5];
-			attr = &ppu.nameTables[1].attr[(tileLine >> 2) << 3];
-		}
-
-		// pre-build attribute table lookup into one big 32 bit int
-		// this is done backwards so the value is easily popped later
-		int attrX = (ppu.SCROLLX >> 5) & 7;
-		int attrShift = (tileLine & 2) << 1;	// 4 bit shift for bottom row of attribute
-		unsigned int attrPalette = 0;
-		for (int loop = 0; loop < 8; loop++) {
-			attrPalette <<= 4;
-			attrPalette |= ((attr[attrX] >> attrShift) & 0xF);
-			attrX = (attrX + 7) & 7;
-		}
-
-		if ((ppu.SCROLLX & 0x10) == 0) {
-			attrPalette = (attrPalette << 6) | (attrPalette >> 26);
-		} else {
-			attrPalette = (attrPalette << 4) | (attrPalette >> 28);
-		}
+	// two 32 bit lanes mixing each aligned word covering the visible pixels with a multiply and rotate (so unlike plain
+	// sums no small set of offsetting pixel changes leaves them unchanged), seeded with everything else the resolved line
+	// depends on. Each lane runs even and odd words as separate chains to overlap the multiplies, folded at the end
+	const uint32* words = (const uint32*) &scanlineBuffer[8];
+	const uint32 seed = workingPaletteHash ^ (scrollOffset << 8);
+	uint32 hash1 = seed, hash1Odd = seed ^ 0x55555555;
+	uint32 hash2 = ~seed, hash2Odd = ~seed ^ 0x55555555;
+	for (int i = 0; i < 64; i += 2) {
+		hash1 = (hash1 ^ words[i + 0]) * 0x9E3779B1;
+		hash2 = (hash2 + words[i + 0]) * 0x85EBCA77;
+		hash1Odd = (hash1Odd ^ words[i + 1]) * 0x9E3779B1;
+		hash2Odd = (hash2Odd + words[i + 1]) * 0x85EBCA77;
+		hash1 = (hash1 << 15) | (hash1 >> 17);
+		hash2 = (hash2 << 13) | (hash2 >> 19);
+		hash1Odd = (hash1Odd << 15) | (hash1Odd >> 17);
+		hash2Odd = (hash2Odd << 13) | (hash2Odd >> 19);
+	}
+	hash1 = (hash1 + ((hash1Odd << 16) | (hash1Odd >> 16))) * 0x9E3779B1;
+	hash2 = (hash2 + ((hash2Odd << 16) | (hash2Odd >> 16))) * 0x85EBCA77;
 
-		// we render 16 pixels at a time (easy attribute table lookup), 17 times and clip
-		uint8* buffer = ppu.scanlineBuffer;
-		int tileX = (ppu.SCROLLX >> 4) * 2;	// always start on an even numbered tile
-		uint32 lastChr = -1;
+	if (lineHash[0] == hash1 && lineHash[1] == hash2) {
+		linesSkipped++;
+		totalLinesSkipped++;
+		return true;
+	}
 
-		for (int loop = 0; loop < 17; loop++) {
-			// grab and rotate palette selection
-			uint32 palette = (attrPalette & 0x0C);
-			Rotate_2Bit(attrPalette);
+	lineHash[0] = hash1;
+	lineHash[1] = hash2;
+	return false;
+}
 
-			// keep tileX mirroring
-			tileX &= 0x1F;
+void nes_ppu::invalidateResolvedLines() {
+	memset(resolvedLineHash, 0xFF, sizeof(resolvedLineHash));
+	dirtyFrame = true;
 
-			uint8 chr1 = nameTable[tileX++];
-			uint8 chr2 = nameTable[tileX++];
-			uint32 chrSig = (chr1 << 16) | (chr2 << 8) | palette;
+#if PPU_RENDER_THREAD
+	// lines are resolved by the render thread's copy
+	if (this == &nesPPU) {
+		RenderThread_InvalidateResolvedLines();
+	}
+#endif
+}
 
-			if (chrSig == lastChr) {
-				CopyOver16(buffer - 16);
-				buffer += 16;
-			} else {
-				UnrollPalette(palette);
-				lastChr = chrSig;
+bool nes_ppu::checkStaticFrame(bool bSkipFrame) {
+	nes_render_state state;
+	memset(&state, 0, sizeof(state));
+	state.chrPages[0] = chrPages[0];
+	state.chrPages[1] = chrPages[1];
+	state.scrollY = scrollY;
+	state.mirror = mirror;
+	state.PPUCTRL = PPUCTRL;
+	state.PPUMASK = PPUMASK;
+	state.SCROLLX = SCROLLX;
+	state.flipY = flipY;
+
+	// MMC2/4 latches are only updated while rendering
+	const bool bUnchanged = !dirtyFrame && !nesCart.renderLatch && !memcmp(&state, &lastRenderState, sizeof(state));
+
+	// an interlaced frame only renders one field, so the frame after a change renders the other even if unchanged
+	const bool bStatic = bUnchanged && !interlaceFieldPending;
+	interlaceFieldPending = interlaceFrame && !bUnchanged;
+	if (bStatic) {
+		staticFrames++;
+	}
 
-				RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-				buffer += 8;
-				RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-				buffer += 8;
-			}
-		}
-	} else {
-		for (int i = 0; i < 288; i++) {
-			ppu.scanlineBuffer[i] = 0;
-		}
-		if (ppu.causeDecrement) {
-			ppu.scrollY--;
-		}
+	if (bStatic || !bSkipFrame) {
+		lastRenderState = state;
+		dirtyFrame = false;
 	}
 
-	ppu.doOAMRender();
+	return bStatic;
 }
 
-void nes_ppu::renderScanline_HorzMirror(nes_ppu& ppu) {
-	TIME_SCOPE_NAMED(scanline_horz);
+inline void UnrollPalette(uint32& palette) {
+	// put palette in every 4 bytes (* 2 to account for offset into word sized color table during resolve)
+	palette <<= 1;
+	palette = palette | (palette << 8);
+	palette = palette | (palette << 16);
+}
+
+// renders the background of the current scanline, then its sprites. Specialized per mirroring (MMC2/4 render latches
+// are only supported with horizontal and vertical mirroring) and sprite size, selected by selectRenderScanline
+template<int mirror, bool hasLatch, int spriteSize>
+static void RenderScanline(nes_ppu& ppu) {
+	TIME_SCOPE_NAMED(renderScanline);
 
 	DebugAssert(ppu.scanline >= 1 && ppu.scanline <= 240);
 
+	// vertical and 4 pane mirroring render from two nametables side by side, the rest wrap within one
+	const bool twoTables = (mirror == nes_mirror_type::MT_VERTICAL || mirror == nes_mirror_type::MT_4PANE);
+
 	int line = ppu.scanline - 1;
 	if (ppu.scrollY < 240) {
 		line += ppu.scrollY;
 	} else {
-		// "negative scroll" which we'll just skip the top lines for
+		// "negative scroll" which we'll just skip the top lines for (two table modes wrap them instead)
 		line += ppu.scrollY - 256;
 	}
 
-	if ((ppu.PPUMASK & PPUMASK_SHOWBG) && line >= 0) {
+	if ((ppu.PPUMASK & PPUMASK_SHOWBG) && (twoTables || line >= 0)) {
 		int tileLine = line >> 3;
+		int scrollX = ppu.SCROLLX;
 
-		// determine base addresses
-		unsigned char* nameTable;
-		unsigned char* attr;
-		unsigned int chrOffset = (line & 7);
-		unsigned char* patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-
-		if (ppu.flipY) {
-			tileLine += 30;
-			if (tileLine >= 60) tileLine -= 60;
-		}
-
-		if (tileLine < 30) {
-			nameTable = &ppu.nameTables[0].table[tileLine << 5];
-			attr = &ppu.nameTables[0].attr[(tileLine >> 2) << 3];
-		} else {
-			tileLine -= 30;
-			nameTable = &ppu.nameTables[1].table[tileLine << 5];
-			attr = &ppu.nameTables[1].attr[(tileLine >> 2) << 3];
-		}
-
-		// pre-build attribute table lookup into one big 32 bit int
-		// this is done backwards so the value is easily popped later
-		uint32 attrX = (ppu.SCROLLX >> 5) & 7;
-		unsigned int attrPalette = 0;
-		if (tileLine & 2) { // 4 bit shift for bottom row of attribute
-			attrPalette = attr[attrX] >> 4;
-			attrX = (attrX + 7) & 7;
-			for (int loop = 0; loop < 7; loop++) {
-				attrPalette <<= 4;
-				attrPalette |= (attr[attrX] >> 4);
-				attrX = (attrX + 7) & 7;
+		// nametable the row starts from (the left one for two table modes)
+		int nameTableIndex = 0;
+		if (mirror == nes_mirror_type::MT_SINGLE || mirror == nes_mirror_type::MT_SINGLE_UPPER) {
+			if (tileLine >= 30) {
+				tileLine -= 30;
 			}
-		} else {
-			attrPalette |= (attr[attrX] & 0xF);
-			attrX = (attrX + 7) & 7;
-			for (int loop = 0; loop < 7; loop++) {
-				attrPalette <<= 4;
-				attrPalette |= (attr[attrX] & 0xF);
-				attrX = (attrX + 7) & 7;
+			nameTableIndex = (mirror == nes_mirror_type::MT_SINGLE_UPPER) ? 1 : 0;
+		} else if (mirror == nes_mirror_type::MT_HORIZONTAL) {
+			if (ppu.flipY) {
+				tileLine += 30;
+				if (tileLine >= 60) tileLine -= 60;
 			}
-		}
-
-		if ((ppu.SCROLLX & 0x10) == 0) {
-			attrPalette = (attrPalette << 6) | (attrPalette >> 26);
-		} else {
-			attrPalette = (attrPalette << 4) | (attrPalette >> 28);
-		}
-
-		// we render 16 pixels at a time (easy attribute table lookup), 17 times and clip
-		uint8* buffer = ppu.scanlineBuffer;
-		int tileX = (ppu.SCROLLX >> 4) * 2;	// always start on an even numbered tile
-
-		// MMC2/4 too branch here for faster code:
-		if (nesCart.renderLatch) {
-			uint32 lastChr = -1;
-			for (int loop = 0; loop < 17; loop++) {
-				// grab and rotate palette selection
-				uint32 palette = (attrPalette & 0x0C);
-				Rotate_2Bit(attrPalette);
-
-				// keep tileX mirroring
-				tileX &= 0x1F;
-
-				uint8 chr1 = nameTable[tileX++];
-				uint8 chr2 = nameTable[tileX++];
-				uint32 chrSig = (chr1 << 16) | (chr2 << 8) | palette;
-
-				if (chrSig == lastChr) {
-					CopyOver16(buffer - 16);
-					buffer += 16;
-				} else {
-					UnrollPalette(palette);
-					lastChr = chrSig;
-
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					if (chr1 >= 0xFD) {
-						nesCart.renderLatch((chr1 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-					}
-					buffer += 8;
-					RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-					if (chr2 >= 0xFD) {
-						nesCart.renderLatch((chr2 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-					}
-					buffer += 8;
-				}
+			if (tileLine >= 30) {
+				tileLine -= 30;
+				nameTableIndex = 1;
 			}
-		} else {
-			uint32 lastChr = -1;
-
-			for (int loop = 0; loop < 17; loop++) {
-				// grab and rotate palette selection
-				uint32 palette = (attrPalette & 0x0C);
-				Rotate_2Bit(attrPalette);
-
-				// keep tileX mirroring
-				tileX &= 0x1F;
-
-				uint32 chr1 = nameTable[tileX++];
-				uint32 chr2 = nameTable[tileX++] << 8;
-				uint32 chrSig = (chr1 << 16) | chr2 | palette;
-
-				if (chrSig == lastChr) {
-					CopyOver16(buffer - 16);
-				} else {
-					UnrollPalette(palette);
-					lastChr = chrSig;
-
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					RenderToScanline(patternTable, chr2 >> 4, palette, buffer + 8);
-				}
-
-				buffer += 16;
+		} else if (mirror == nes_mirror_type::MT_VERTICAL) {
+			if (tileLine >= 30) {
+				tileLine -= 30;
+			} else if (tileLine < 0) {
+				tileLine += 30;
 			}
-		}
-	} else {
-		for (int i = 0; i < 288; i++) {
-			ppu.scanlineBuffer[i] = 0;
-		}
-		if (ppu.causeDecrement) {
-			ppu.scrollY--;
-		}
-	}
-
-	ppu.doOAMRender();
-}
-
-template<bool hasLatch, bool is4Pane>
-static void renderScanline_VertMirror_Latched(nes_ppu& ppu) {
-	DebugAssert(ppu.scanline >= 1 && ppu.scanline <= 240);
-	if (ppu.PPUMASK & PPUMASK_SHOWBG) {
-		int line = ppu.scanline - 1;
-
-		if (ppu.scrollY < 240) {
-			line += ppu.scrollY;
 		} else {
-			// "negative scroll" which we'll just skip the top lines for
-			line += ppu.scrollY - 256;
-		}
-
-		int tileLine = line >> 3;
-
-		int nameTableIndex = 0;
-		if (is4Pane) {
 			if (tileLine >= 60) {
 				tileLine -= 60;
-			}
-			else if (tileLine < 0) {
+			} else if (tileLine < 0) {
 				tileLine += 60;
 			}
 			if (tileLine >= 30) {
@@ -1225,166 +1521,84 @@ static void renderScanline_VertMirror_Latched(nes_ppu& ppu) {
 			if (ppu.PPUCTRL & PPUCTRL_FLIPYTBL) {
 				nameTableIndex = nameTableIndex ^ 2;
 			}
-		} else {
-			if (tileLine >= 30) {
-				tileLine -= 30;
-			} else if (tileLine < 0) {
-				tileLine += 30;
-			}
 		}
 
-		int scrollX = ppu.SCROLLX;
+		if (twoTables && (ppu.PPUCTRL & PPUCTRL_FLIPXTBL)) {
+			scrollX += 256;
+		}
 
 		// determine base addresses
-		unsigned char* nameTable;
-		unsigned char* attr;
-		const bool attrShift = (tileLine & 2);	// 4 bit shift for bottom row of attribute
-		unsigned int chrOffset = (line & 7);
-		unsigned char* patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
+		const int tileXMask = twoTables ? 0x3F : 0x1F;
+		int tileX = ((scrollX >> 4) * 2) & tileXMask;	// always start on an even numbered tile
+		const unsigned int chrOffset = (line & 7);
+		const unsigned int attrShift = (tileLine & 2) << 1;	// 4 bit shift for bottom row of attribute
+
+		const unsigned char* nameRows[2];
+		const unsigned char* attrRows[2];
+		nameRows[0] = &ppu.nameTables[nameTableIndex].table[tileLine << 5];
+		attrRows[0] = &ppu.nameTables[nameTableIndex].attr[(tileLine >> 2) << 3];
+		if (twoTables) {
+			nameRows[1] = &ppu.nameTables[nameTableIndex ^ 1].table[tileLine << 5];
+			attrRows[1] = &ppu.nameTables[nameTableIndex ^ 1].attr[(tileLine >> 2) << 3];
+		} else {
+			nameRows[1] = nameRows[0];
+			attrRows[1] = attrRows[0];
+		}
 
-		if (ppu.PPUCTRL & PPUCTRL_FLIPXTBL) scrollX += 256;
+		// MMC2/4 latches switch pages while rendering, so their rows aren't cached
+		if (!hasLatch && FetchBGRow(ppu, nameRows, chrOffset, tileX)) {
+			ppu.doOAMRender<spriteSize>();
+			return;
+		}
+
+		unsigned char* patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
+		nes_decoded_chr_page* decodedPage = TakeDecodedCHRPage(ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4]);
 
 		// we render 16 pixels at a time (easy attribute table lookup), 17 times and clip
 		uint8* buffer = ppu.scanlineBuffer;
-		int tileX = ((scrollX >> 4) * 2) & 0x3F;	// always start on an even numbered tile
-		nameTableIndex += (tileX & 0x20) >> 5;
-		
-		nameTable = &ppu.nameTables[nameTableIndex].table[tileLine << 5];
-		attr = &ppu.nameTables[nameTableIndex].attr[(tileLine >> 2) << 3];
-
-		// render tileX up to the end of the current nametable
-		int curTileX = tileX & 0x1F;
 		uint32 lastChr = -1;
-		while (curTileX < 32) {
-			// grab and rotate palette selection
-			bool hadLatch = false;
-			uint32 attrPalette;
-			if (attrShift) {
-				attrPalette = (attr[(curTileX >> 2)] >> 2) >> (curTileX & 2);
-			} else {
-				attrPalette = (attr[(curTileX >> 2)] << 2) >> (curTileX & 2);
-			}
+		for (int loop = 0; loop < 17; loop++) {
+			const unsigned int side = twoTables ? (tileX >> 5) : 0;
+			const unsigned int x = tileX & 0x1F;
+			tileX = (tileX + 2) & tileXMask;
 
-			uint32 palette = (attrPalette & 0x0C);
-			
-			uint8 chr1 = nameTable[curTileX++];
-			uint8 chr2 = nameTable[curTileX++];
+			uint32 palette = ((attrRows[side][x >> 2] >> (attrShift + (x & 2))) << 2) & 0x0C;
+			uint32 chr1 = nameRows[side][x];
+			uint32 chr2 = nameRows[side][x + 1];
 			uint32 chrSig = (chr1 << 16) | (chr2 << 8) | palette;
 
 			if (chrSig == lastChr) {
 				CopyOver16(buffer - 16);
-				buffer += 16;
 			} else {
 				UnrollPalette(palette);
 				lastChr = chrSig;
 
-				if (hasLatch) {
-					if (chr1 == 0xFD || chr1 == 0xFE) {
-						nesCart.renderLatch((chr1 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						hadLatch = true;
-					}
-
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					buffer += 8;
-
-					if (hadLatch) {
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-						hadLatch = false;
-					}
-
-					if (chr2 == 0xFD || chr2 == 0xFE) {
-						nesCart.renderLatch((chr2 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						hadLatch = true;
-					}
-
-					RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-					buffer += 8;
-
-					if (hadLatch) {
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-						hadLatch = false;
-					}
-				} else {
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					buffer += 8;
-					RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-					buffer += 8;
+				RenderTileRow(decodedPage, patternTable, chr1, chrOffset, palette, buffer);
+				if (hasLatch && (chr1 == 0xFD || chr1 == 0xFE)) {
+					nesCart.renderLatch((chr1 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
+					patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
+					decodedPage = TakeDecodedCHRPage(ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4]);
 				}
-			}
-		}
-
-		// now render the other nametable until scanline is complete
-		curTileX = 0;
-		nameTableIndex = nameTableIndex ^ 1;
-		nameTable = &ppu.nameTables[nameTableIndex].table[tileLine << 5];
-		attr = &ppu.nameTables[nameTableIndex].attr[(tileLine >> 2) << 3];
-		uint8* bufferEnd = &ppu.scanlineBuffer[16 * 17];
 
-		while (buffer < bufferEnd) {
-			// grab and rotate palette selection
-			bool hadLatch = false;
-			uint32 attrPalette;
-			if (attrShift) {
-				attrPalette = (attr[(curTileX >> 2)] >> 2) >> (curTileX & 2);
-			} else {
-				attrPalette = (attr[(curTileX >> 2)] << 2) >> (curTileX & 2);
-			}
-			uint32 palette = (attrPalette & 0x0C);
-
-			uint8 chr1 = nameTable[curTileX++];
-			uint8 chr2 = nameTable[curTileX++];
-			uint32 chrSig = (chr1 << 16) | (chr2 << 8) | palette;
-			
-			if (chrSig == lastChr) {
-				CopyOver16(buffer - 16);
-				buffer += 16;
-			} else {
-				UnrollPalette(palette);
-				lastChr = chrSig;
-
-				if (hasLatch) {
-					if (chr1 == 0xFD || chr1 == 0xFE) {
-						nesCart.renderLatch((chr1 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						hadLatch = true;
-					}
-
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					buffer += 8;
-
-					if (hadLatch) {
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-						hadLatch = false;
-					}
-
-					if (chr2 == 0xFD || chr2 == 0xFE) {
-						nesCart.renderLatch((chr2 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-						hadLatch = true;
-					}
-
-					RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-					buffer += 8;
-
-					if (hadLatch) {
-						patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
-						hadLatch = false;
-					}
-				} else {
-					RenderToScanline(patternTable, chr1 << 4, palette, buffer);
-					buffer += 8;
-					RenderToScanline(patternTable, chr2 << 4, palette, buffer);
-					buffer += 8;
+				RenderTileRow(decodedPage, patternTable, chr2, chrOffset, palette, buffer + 8);
+				if (hasLatch && (chr2 == 0xFD || chr2 == 0xFE)) {
+					nesCart.renderLatch((chr2 << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
+					patternTable = ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4] + chrOffset;
+					decodedPage = TakeDecodedCHRPage(ppu.chrPages[(ppu.PPUCTRL & PPUCTRL_BGDTABLE) >> 4]);
 				}
 			}
+
+			buffer += 16;
 		}
 
-		if (hasLatch) {
+		if (!hasLatch) {
+			StoreBGRow(ppu);
+		} else {
 			// fetch 34th tile
-			if (buffer < bufferEnd + 8 && curTileX < 32) {
-				int chr = nameTable[curTileX];
-
-				if (chr == 0xFD || chr == 0xFE) {
-					nesCart.renderLatch((chr << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
-				}
+			const unsigned int side = twoTables ? (tileX >> 5) : 0;
+			const unsigned int chr = nameRows[side][tileX & 0x1F];
+			if (chr == 0xFD || chr == 0xFE) {
+				nesCart.renderLatch((chr << 4) + chrOffset + 8 + ((ppu.PPUCTRL & PPUCTRL_BGDTABLE) << 8));
 			}
 		}
 	} else {
@@ -1395,52 +1609,58 @@ static void renderScanline_VertMirror_Latched(nes_ppu& ppu) {
 			ppu.scrollY--;
 		}
 	}
-	 
-	ppu.doOAMRender();
-}
-
-void nes_ppu::renderScanline_VertMirror(nes_ppu& ppu) {
-	TIME_SCOPE();
 
-	if (nesCart.renderLatch) {
-		renderScanline_VertMirror_Latched<true, false>(ppu);
-	} else {
-		renderScanline_VertMirror_Latched<false, false>(ppu);
-	}
+	ppu.doOAMRender<spriteSize>();
 }
 
-void nes_ppu::renderScanline_4PaneMirror(nes_ppu& ppu) {
-	renderScanline_VertMirror_Latched<false, true>(ppu);
+typedef void(*render_scanline_func)(nes_ppu& ppu);
+
+template<int mirror, bool hasLatch>
+static render_scanline_func RenderScanlineFor(bool sprite16) {
+	return sprite16 ? RenderScanline<mirror, hasLatch, 16> : RenderScanline<mirror, hasLatch, 8>;
 }
 
-void nes_ppu::setMirrorType(int withType) {
-	if (mirror == withType) {
-		return;
-	}
+void nes_ppu::selectRenderScanline() {
+	const bool sprite16 = (PPUCTRL & PPUCTRL_SPRSIZE) != 0;
+	const bool latch = nesCart.renderLatch != NULL;
 
-	mirror = withType;
 	switch (mirror) {
 		case nes_mirror_type::MT_HORIZONTAL:
-			renderScanline = renderScanline_HorzMirror;
+			renderScanline = latch ? RenderScanlineFor<nes_mirror_type::MT_HORIZONTAL, true>(sprite16) : RenderScanlineFor<nes_mirror_type::MT_HORIZONTAL, false>(sprite16);
 			break;
 		case nes_mirror_type::MT_VERTICAL:
-			renderScanline = renderScanline_VertMirror;
+			renderScanline = latch ? RenderScanlineFor<nes_mirror_type::MT_VERTICAL, true>(sprite16) : RenderScanlineFor<nes_mirror_type::MT_VERTICAL, false>(sprite16);
 			break;
 		case nes_mirror_type::MT_SINGLE:
+			renderScanline = RenderScanlineFor<nes_mirror_type::MT_SINGLE, false>(sprite16);
+			break;
 		case nes_mirror_type::MT_SINGLE_UPPER:
-			renderScanline = renderScanline_SingleMirror;
+			renderScanline = RenderScanlineFor<nes_mirror_type::MT_SINGLE_UPPER, false>(sprite16);
 			break;
 		case nes_mirror_type::MT_4PANE:
-			renderScanline = renderScanline_4PaneMirror;
+			renderScanline = RenderScanlineFor<nes_mirror_type::MT_4PANE, false>(sprite16);
 			break;
 	}
 }
 
+void nes_ppu::setMirrorType(int withType) {
+	if (mirror == withType) {
+		return;
+	}
+
+	catchUp();
+	mirror = withType;
+	selectRenderScanline();
+}
+
 void nes_ppu::init() {
 	memset(this, 0, sizeof(nes_ppu));
 	scanline = 1;
 	mirror = nes_mirror_type::MT_UNSET;
 	autoFrameSkip = 0;
+	dirtyOAM = true;
+	BuildSpriteRowTables();
+	invalidateResolvedLines();
 }
 
 void nes_ppu::initTV() {
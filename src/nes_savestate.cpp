@@ -183,6 +183,8 @@ struct FCEUX_File {
 				HandleSubsection(ST_EXTRA, IRQA, 1);
 				HandleSubsection(ST_EXTRA, RMOD, 1);
 				HandleSubsection(ST_EXTRA, IRQM, 1);
+				// Sunsoft 3 IRQ timing
+				HandleSubsection(ST_EXTRA, IRQT, 8);
 				// MMC2 / AVE
 				if (nesCart.mapper == 79) {
 					HandleSubsection(ST_EXTRA, CREG, 1);
@@ -249,6 +251,7 @@ struct FCEUX_File {
 			size -= 0x400;
 			curTable++;
 		}
+		nesPPU.invalidateRenderedMemory();
 	}
 
 	// palette memory
@@ -272,6 +275,10 @@ struct FCEUX_File {
 
 		nesPPU.memoryMap[2] = data[2];
 		nesPPU.memoryMap[4] = data[3];
+
+		// sprite size may have changed
+		nesPPU.dirtyOAM = true;
+		nesPPU.selectRenderScanline();
 	}
 
 	inline void Read_ST_PPU_XOFF(uint8* data, uint32) {
@@ -315,6 +322,9 @@ struct FCEUX_File {
 		if (nesCart.numCHRBanks == 0) {
 			memcpy(nesPPU.chrPages[0], data, 0x1000);
 			memcpy(nesPPU.chrPages[1], data + 0x1000, 0x1000);
+			nesPPU.invalidateRenderedMemory();
+			nesPPU.invalidateDecodedCHR(nesPPU.chrPages[0], 0x1000);
+			nesPPU.invalidateDecodedCHR(nesPPU.chrPages[1], 0x1000);
 		}
 	}
 
@@ -468,12 +478,16 @@ struct FCEUX_File {
 		}
 		// Sunsoft-5
 		else if (nesCart.mapper == 69) {
-			uint32 regs[22];
+			uint32 regs[21];
 			memcpy(regs, data, 84);
-			for (int32 r = 0; r <= 21; r++) {
+			for (int32 r = 0; r < 21; r++) {
 				EndianSwap_Big(regs[r]);
 				nesCart.registers[r] = regs[r];
 			}
+
+			// IRQ clocks are saved relative to the CPU clock
+			Mapper69_IRQ = regs[18] ? mainCPU.clocks + (int32) regs[18] : 0;
+			Mapper69_LASTCOUNTERCLK = mainCPU.clocks + (int32) regs[20];
 		}
 		// BNROM
 		else if (nesCart.mapper == 34) {
@@ -558,6 +572,18 @@ struct FCEUX_File {
 		}
 	}
 
+	void Read_ST_EXTRA_IRQT(uint8* data, uint32 size) {
+		// Sunsoft 3 (not FCEUX compatible), the counter and the clocks since it was last set
+		if (nesCart.mapper == 67) {
+			uint32 regs[2];
+			memcpy(regs, data, 8);
+			EndianSwap_Big(regs[0]);
+			EndianSwap_Big(regs[1]);
+			Mapper67_IRQ_Counter = regs[0];
+			Mapper67_IRQ_LastSet = mainCPU.clocks - regs[1];
+		}
+	}
+
 	void Read_ST_EXTRA_CREG(uint8* data, uint32 size) {
 		// MMC2 / MMC4
 		if (nesCart.mapper == 9 || nesCart.mapper == 10) {
@@ -808,6 +834,15 @@ struct FCEUX_File {
 					regs[r] = nesCart.registers[r];
 				}
 				WriteChunk_Data("REGS", 9, regs);
+
+				if (nesCart.mapper == 67) {
+					uint32 irqRegs[2];
+					irqRegs[0] = Mapper67_IRQ_Counter;
+					irqRegs[1] = (uint32) (mainCPU.clocks - Mapper67_IRQ_LastSet);
+					EndianSwap_Big(irqRegs[0]);
+					EndianSwap_Big(irqRegs[1]);
+					WriteChunk_Data("IRQT", 8, irqRegs);
+				}
 			}
 			// GXROM Mapper
 			else if (nesCart.mapper == 66 || nesCart.mapper == 140) {
@@ -818,6 +853,13 @@ struct FCEUX_File {
 				uint32 regs[21];
 				for (int32 r = 0; r < 21; r++) {
 					regs[r] = nesCart.registers[r];
+				}
+
+				// IRQ clocks are saved relative to the CPU clock
+				regs[18] = Mapper69_IRQ ? (uint32) (Mapper69_IRQ - mainCPU.clocks) : 0;
+				regs[20] = (uint32) (Mapper69_LASTCOUNTERCLK - mainCPU.clocks);
+
+				for (int32 r = 0; r < 21; r++) {
 					EndianSwap_Big(regs[r]);
 				}
 				WriteChunk_Data("REGS", 84, regs);
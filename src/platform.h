@@ -4,6 +4,10 @@
 #include "string.h"
 #include "stdlib.h"
 
+#if TARGET_HOST
+// headless linux build, see src/host
+#include "host/host_fxcg.h"
+#else
 #include "fxcg\display.h"
 #include "fxcg\keyboard.h"
 #include "fxcg\file.h"
@@ -11,6 +15,7 @@
 #include "fxcg\rtc.h"
 #include "fxcg\system.h"
 #include "fxcg\serial.h"
+#endif
 
 typedef signed char int8;
 typedef unsigned char uint8;
@@ -31,6 +36,12 @@ extern "C" {
 	int simmain(void);
 }
 
+#elif TARGET_HOST
+#define ALIGN(x) __attribute__((aligned(x)))
+#define LITTLE_E
+#define FORCE_INLINE __attribute__((always_inline)) inline
+#define RESTRICT __restrict__
+
 #else
 
 #define ALIGN(x) __attribute__((aligned(x)))
@@ -86,6 +97,20 @@ static inline void EndianSwap(unsigned int& i) {
 #define min(a,b)            (((a) < (b)) ? (a) : (b))
 #endif
 
+// master clock type. 64 bit so it never needs rebasing, except on the Prizm where 64 bit adds and compares in the
+// interpreter loop are costly. There it is 32 bit and wraps every ~40 minutes of play, which is harmless as long as
+// clocks are compared with CLOCKS_BEFORE (all deadlines are well within 2^31 clocks of the current time)
+#if TARGET_PRIZM
+typedef unsigned int cpu_clock;
+typedef int cpu_clock_delta;
+#else
+typedef unsigned long long cpu_clock;
+typedef long long cpu_clock_delta;
+#endif
+
+// true if clock a is before clock b
+#define CLOCKS_BEFORE(a, b) ((cpu_clock_delta) ((a) - (b)) < 0)
+
 // #include "ScopeTimer.h"
 
 extern void ScreenPrint(char* buffer);
@@ -46,6 +46,8 @@ static inline void DmaWaitNext(void) {
 }
 
 static inline void DmaDrawStrip(void* srcAddress, unsigned int size) {
+	DebugAssert((size & 31) == 0);	// the transfer count drops any remainder, leaving stale pixels
+
 	// disable dma so we can issue new command
 	*DMA0_CHCR_0 &= ~1;
 	*DMA0_DMAOR = 0;
@@ -193,40 +195,72 @@ func_renderScanline interlaced43Funcs[4] = {
 
 #endif
 
+// last scanline resolved into the current scan group
+static unsigned int lastScan = 0;
+
+// sends the lines resolved into the current scan group, the last of which is the given scanline
+static void flushScanLines(int startX, int width, unsigned int lastScanline) {
+	flushScanBuffer(startX + nesPPU.scanlineOffset, startX + width - 1 + nesPPU.scanlineOffset, lastScanline - 9 - curScan + 1, lastScanline - 9, curScan * width * 2);
+}
+
+// sends the current scan group if it has any lines
+static void flushScanGroup() {
+	if (curScan) {
+		switch (nesSettings.GetSetting(ST_StretchScreen)) {
+			case 1: flushScanLines(48, 300, lastScan); break;
+			case 2: flushScanLines(18, 360, lastScan); break;
+			default: flushScanLines(78, 240, lastScan); break;
+		}
+	}
+}
+
 void nes_ppu::resolveScanline(int scrollOffset) {
 	TIME_SCOPE();
 
-	if (nesSettings.GetSetting(ST_StretchScreen) == 1) {
+	// lines that weren't resolved (the other field's bands when rendering interlaced) break up the scan group DMA
+	if (scanline != lastScan + 1) {
+		flushScanGroup();
+	}
+
+	// unchanged lines are skipped, which also breaks up the scan group DMA (not in the stretched modes, which interlace
+	// each frame, or each time the line is resolved when rendering interlaced)
+	const int stretchMode = nesSettings.GetSetting(ST_StretchScreen);
+	const unsigned int stretchFrame = interlaceFrame ? (dmaFrame >> 1) : dmaFrame;
+	const unsigned int interlacePhase = (stretchFrame + scanline) & 1;
+	if (stretchMode == 0 && lineUnchanged(scrollOffset)) {
+		flushScanGroup();
+		return;
+	}
+	lastScan = scanline;
+
+	if (stretchMode == 1) {
 		const unsigned int bufferLines = 12;	// 600 bytes * 12 lines = 7200
 
 		// resolve le line
 		unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
 		unsigned int* scanlineDest = (unsigned int*)(scanGroup[curDMABuffer] + 300 * curScan);
-		interlaced43Funcs[(dmaFrame + scanline) & 1](scanlineSrc, scanlineDest);
+		interlaced43Funcs[interlacePhase](scanlineSrc, scanlineDest);
 
 		curScan++;
 		if (curScan == bufferLines || scanline == 232) {
 			// send DMA
-			const unsigned int scanBufferSize = curScan * 300 * 2;
-			flushScanBuffer(48 + scanlineOffset, 347 + scanlineOffset, scanline - 9 - curScan + 1, scanline - 9, scanBufferSize);
+			flushScanLines(48, 300, scanline);
 		}
-	} else if (nesSettings.GetSetting(ST_StretchScreen) == 2) {
+	} else if (stretchMode == 2) {
 		const unsigned int bufferLines = 8;	// 720 bytes * 8 lines = 5760
-		const unsigned int scanBufferSize = bufferLines * 360 * 2;
 
 		// resolve le line
 		unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
 		unsigned int* scanlineDest = (unsigned int*)(scanGroup[curDMABuffer] + 360 * curScan);
-		interlacedWideFuncs[(dmaFrame + scanline) & 1](scanlineSrc, scanlineDest);
+		interlacedWideFuncs[interlacePhase](scanlineSrc, scanlineDest);
 
 		curScan++;
-		if (curScan == bufferLines) {
+		if (curScan == bufferLines || scanline == 232) {
 			// send DMA
-			flushScanBuffer(18 + scanlineOffset, 377 + scanlineOffset, scanline - 9 - bufferLines + 1, scanline - 9, scanBufferSize);
+			flushScanLines(18, 360, scanline);
 		}
 	} else {
 		const unsigned int bufferLines = 16;	// 480 bytes * 16 lines = 7680
-		const unsigned int scanBufferSize = bufferLines * 240 * 2;
 
 		// resolve le line
 		unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
@@ -234,9 +268,9 @@ void nes_ppu::resolveScanline(int scrollOffset) {
 		RenderScanlineBuffer(scanlineSrc, scanlineDest);
 
 		curScan++;
-		if (curScan == bufferLines) {
+		if (curScan == bufferLines || scanline == 232) {
 			// send DMA
-			flushScanBuffer(78 + scanlineOffset, 317 + scanlineOffset, scanline - 9 - bufferLines + 1, scanline - 9, scanBufferSize);
+			flushScanLines(78, 240, scanline);
 		}
 	}
 }
@@ -319,6 +353,9 @@ void nes_ppu::finishFrame(bool bSkippedFrame) {
 	}
 
 	if (!bSkippedFrame) {
+		// the last field line may be before the end of the screen
+		flushScanGroup();
+
 		// frame end.. kill DMA operations to make sure they stay in sync
 		DmaWaitNext();
 		*((volatile unsigned*)MSTPCR0) &= ~(1 << 21);//Clear bit 21
@@ -8,15 +8,32 @@
 #include "settings.h"
 #include "imageDraw.h"
 #include "frontend.h"
+#include "scope_timer/scope_timer.h"
+
+#if TARGET_HOST
+#include "host/host_simd.h"
+#endif
 
 void nes_ppu::resolveScanline(int scrollOffset) {
 	TIME_SCOPE();
 
-	if (nesPPU.scanline >= 13 && nesPPU.scanline <= 228) {
+	if (scanline >= 13 && scanline <= 228) {
+		// unchanged lines are left on screen (not in the stretched modes, which interlace differently each frame)
+		if (nesSettings.GetSetting(ST_StretchScreen) == 0 && lineUnchanged(scrollOffset)) {
+			return;
+		}
+
+		// stretched modes interlace differently each frame (each time the line is resolved when rendering interlaced,
+		// which is every other frame)
+		const unsigned int stretchFrame = interlaceFrame ? (frameCounter >> 1) : frameCounter;
+
 		if (nesSettings.GetSetting(ST_StretchScreen) == 1) {
-			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (nesPPU.scanline - 13) * 384 + 42 + scanlineOffset;
-			unsigned char* scanlineSrc = &nesPPU.scanlineBuffer[8 + scrollOffset];	// with clipping
-			const int interlacePixel = (nesPPU.frameCounter + nesPPU.scanline) & 3;
+			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (scanline - 13) * 384 + 42 + scanlineOffset;
+			unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
+			const int interlacePixel = (stretchFrame + scanline) & 3;
+#if TARGET_HOST
+			hostKernels.resolveLine43(scanlineSrc, workingPalette, scanlineDest, interlacePixel);
+#else
 			for (int i = 0; i < 60; i++) {
 				const uint16 pixels[4] = {
 					workingPalette[(*scanlineSrc++) >> 1],
@@ -30,10 +47,14 @@ void nes_ppu::resolveScanline(int scrollOffset) {
 					if (j != interlacePixel) pixel++;
 				}
 			}
+#endif
 		} else if (nesSettings.GetSetting(ST_StretchScreen) == 2) {
-			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (nesPPU.scanline - 13) * 384 + 12 + scanlineOffset;
-			unsigned char* scanlineSrc = &nesPPU.scanlineBuffer[8 + scrollOffset];	// with clipping
-			const bool bInterlace = (nesPPU.frameCounter + nesPPU.scanline) & 1;
+			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (scanline - 13) * 384 + 12 + scanlineOffset;
+			unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
+			const bool bInterlace = (stretchFrame + scanline) & 1;
+#if TARGET_HOST
+			hostKernels.resolveLineWide(scanlineSrc, workingPalette, scanlineDest, bInterlace);
+#else
 			for (int i = 0; i < 120; i++) {
 				const uint16 pixel1 = workingPalette[(*scanlineSrc++) >> 1];
 				const uint16 pixel2 = workingPalette[(*scanlineSrc++) >> 1];
@@ -41,12 +62,17 @@ void nes_ppu::resolveScanline(int scrollOffset) {
 				*(scanlineDest++) = bInterlace ? pixel1 : pixel2;
 				*(scanlineDest++) = pixel2;
 			}
+#endif
 		} else {
-			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (nesPPU.scanline - 13) * 384 + 72 + scanlineOffset;
-			unsigned char* scanlineSrc = &nesPPU.scanlineBuffer[8 + scrollOffset];	// with clipping
+			unsigned short* scanlineDest = ((unsigned short*)GetVRAMAddress()) + (scanline - 13) * 384 + 72 + scanlineOffset;
+			unsigned char* scanlineSrc = &scanlineBuffer[8 + scrollOffset];	// with clipping
+#if TARGET_HOST
+			hostKernels.resolveLine(scanlineSrc, workingPalette, scanlineDest);
+#else
 			for (int i = 0; i < 240; i++, scanlineSrc++) {
 				*(scanlineDest++) = workingPalette[(*scanlineSrc) >> 1];
 			}
+#endif
 		}
 	}
 }
@@ -59,7 +59,8 @@ static const char* FrameSkipOptions[] = {
 	"1",
 	"2",
 	"3",
-	"4"
+	"4",
+	"Interlace"
 };
 
 static const char* SpeedOptions[] = {
@@ -113,14 +114,14 @@ static const char* ClockOptions[] = {
 static SettingInfo infos[] = {
 	{ ST_AutoSave,			SG_Deprecated,	false,	0,	2,	"Auto Save",		OffOn,				""}, // decided to go with always auto SRAM save, manual state save
 	{ ST_OverClock,			SG_System,		true,   0,  3,  "Overclock",		OverclockOptions,	"Increase calculator clock speed to\nimprove performance (costs battery)"},
-	{ ST_FrameSkip,			SG_System,		true,	0,  6,	"Frame Skip",		FrameSkipOptions,	"Number of frames to skip when\ndrawing screen to improve speed"},
+	{ ST_FrameSkip,			SG_System,		true,	0,  7,	"Frame Skip",		FrameSkipOptions,	"Number of frames to skip when\ndrawing screen, or interlace lines"},
 	{ ST_Speed,				SG_System,		true,	1,	5,	"Speed",			SpeedOptions,		"Desired emulation speed"},
 	{ ST_TwoPlayer,			SG_Deprecated,	false,	0,	2,	"2 Player Mode",	OffOn,				""}, // to use 2 players, just define 2nd player keys
 	{ ST_TurboSetting,		SG_Controls,	true,	2,	5,	"Turbo Key",		TurboKeyOptions,	"Repeat speed of key presses\nwhen using a turbo key."},
 	{ ST_Palette,			SG_Video,		true,	0,	4,	"Palette",			PaletteOptions,		""},
 	{ ST_Background,		SG_Video,		true,	0,	4,	"Background",		BackgroundOptions,	"Select the background behind the\ngame screen when playing"},
 	{ ST_SoundEnabled,		SG_Sound,		true,	0,	2,	"Sound",			OffOn,				"Enable sound. Requires a 2.5mm\nto 3.5 mm adaptor in top port"},
-	{ ST_SoundQuality,		SG_Sound,		true,	0,  2,  "Extra FX",			OffOn,				"Enable extra sound processing.\nCloser emulation at cost of speed."},
+	{ ST_SoundQuality,		SG_Deprecated,	false,	0,  2,  "Extra FX",			OffOn,				""}, // band limited synthesis doesn't need the extra filtering
 	{ ST_DimScreen,			SG_Video,		false,	0,  2,  "Dim Screen",		OffOn,				""}, // now use the brightness option
 	{ ST_StretchScreen,		SG_Video,		true,	0,  3,  "Stretch",			StretchOptions,		"Whether to stretch game screen\n4:3 is closest to original system"},
 	{ ST_ShowClock,			SG_Video,		true,	0,  3,  "Show Clock",		ClockOptions,		"Enable to show current system\ntime in bottom corner."},
@@ -300,5 +301,5 @@ void EmulatorSettings::Save() {
 	DebugAssert(size < 256);
 
 	MCS_CreateDirectory((unsigned char*)settingsDir);
-	MCS_WriteItem((unsigned char*)settingsDir, (unsigned char*)settingsFile, 0, size, (int)(&contents[0]));
+	MCS_WriteItem((unsigned char*)settingsDir, (unsigned char*)settingsFile, 0, size, (size_t)(&contents[0]));
 }
\ No newline at end of file